@@ -0,0 +1,95 @@
+// checksum kernels on one large buffer (CRC-32C on tables and on SSE4.2, XXH64), then an
+// ingest loop: a chunked generator reads blocks out of a source buffer and the consumer
+// copies them to their destination. the checksum is taken in a second pass over the
+// destination, or on the way through with `views::checksum` while each block is in cache
+//
+//   ./bench_checksum [MiB] [block KiB]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "co/checksum.hpp"
+#include "co/chunked.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+template<class F>
+double best_seconds(F f) {
+    double best = 1e9;
+    for (int r = 0; r < 3; ++r) {
+        auto start = clock_type::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(clock_type::now() - start).count());
+    }
+    return best;
+}
+
+// stands in for `read`: each block is copied into the generator's own buffer
+co::chunked_generator<std::byte> read_blocks(std::span<const std::byte> source, std::size_t block) {
+    std::vector<std::byte> buf(block);
+    for (std::size_t at = 0; at < source.size(); at += block) {
+        auto n = std::min(block, source.size() - at);
+        std::memcpy(buf.data(), source.data() + at, n);
+        co_yield std::span<const std::byte>{buf}.first(n);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+    std::size_t block = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64) * 1024;
+
+    std::vector<std::byte> source(mib << 20);
+    for (std::size_t i = 0; i < source.size(); ++i) source[i] = std::byte(i * 2654435761u >> 13);
+    std::vector<std::byte> dest(source.size());
+    auto gbps = [&](double s) { return double(source.size()) / s / 1e9; };
+    volatile std::uint64_t sink = 0;
+
+    std::printf("%zu MiB, sse4.2 %s\n", mib, co::detail::crc32c_kernel == co::detail::crc32c_table ? "no" : "yes");
+    auto* bytes = reinterpret_cast<const unsigned char*>(source.data());
+    std::printf("%-26s %6.2f GB/s\n", "crc32c, tables",
+                gbps(best_seconds([&] { sink = co::detail::crc32c_table(~0u, bytes, source.size()); })));
+    std::printf("%-26s %6.2f GB/s\n", "crc32c, dispatched",
+                gbps(best_seconds([&] { sink = co::detail::crc32c_kernel(~0u, bytes, source.size()); })));
+    std::printf("%-26s %6.2f GB/s\n", "xxh64", gbps(best_seconds([&] {
+                    co::xxhash64 h;
+                    h.update(source);
+                    sink = h.value();
+                })));
+
+    auto copy_all = [&](auto&& blocks) {
+        std::size_t at = 0;
+        for (auto b: blocks) {
+            std::memcpy(dest.data() + at, b.data(), b.size());
+            at += b.size();
+        }
+    };
+    std::printf("\ningest, %zu KiB blocks\n", block / 1024);
+    std::printf("%-26s %6.2f GB/s\n", "no checksum", gbps(best_seconds([&] { copy_all(read_blocks(source, block)); })));
+    std::printf("%-26s %6.2f GB/s\n", "crc32c, second pass", gbps(best_seconds([&] {
+                    copy_all(read_blocks(source, block));
+                    co::crc32c crc;
+                    crc.update(dest);
+                    sink = crc.value();
+                })));
+    std::printf("%-26s %6.2f GB/s\n", "crc32c, views::checksum", gbps(best_seconds([&] {
+                    co::crc32c crc;
+                    copy_all(read_blocks(source, block) | co::views::checksum(crc));
+                    sink = crc.value();
+                })));
+    std::printf("%-26s %6.2f GB/s\n", "xxh64, second pass", gbps(best_seconds([&] {
+                    copy_all(read_blocks(source, block));
+                    co::xxhash64 h;
+                    h.update(dest);
+                    sink = h.value();
+                })));
+    std::printf("%-26s %6.2f GB/s\n", "xxh64, views::checksum", gbps(best_seconds([&] {
+                    co::xxhash64 h;
+                    copy_all(read_blocks(source, block) | co::views::checksum(h));
+                    sink = h.value();
+                })));
+    return 0;
+}
@@ -0,0 +1,74 @@
+// a numeric pipeline stage yielding one int per resume vs `std::span` chunks of them,
+// consumed chunk by chunk (a loop the compiler can vectorise) or flattened back to
+// single elements with `views::flatten`
+//
+//   ./bench_chunked [millions of elements]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "co/chunked.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+static std::uint32_t value(std::uint32_t i) { return i * 2654435761u >> 7; }
+
+co::generator<std::uint32_t> per_element(std::uint32_t n) {
+    for (std::uint32_t i = 0; i < n; ++i) co_yield value(i);
+}
+
+co::chunked_generator<std::uint32_t> chunked(std::uint32_t n, std::size_t chunk) {
+    co::chunk_buffer<std::uint32_t> out{chunk};
+    for (std::uint32_t i = 0; i < n;) {
+        auto run = out.append(std::min<std::size_t>(chunk, n - i));
+        for (auto& v: run) v = value(i++);
+        co_yield out.take();
+    }
+}
+
+__attribute__((noinline)) std::uint64_t sum_elements(std::uint32_t n) {
+    std::uint64_t sum = 0;
+    for (auto v: per_element(n)) sum += v;
+    return sum;
+}
+
+__attribute__((noinline)) std::uint64_t sum_chunks(std::uint32_t n, std::size_t chunk) {
+    std::uint64_t sum = 0;
+    for (auto span: chunked(n, chunk)) {
+        for (auto v: span) sum += v;
+    }
+    return sum;
+}
+
+__attribute__((noinline)) std::uint64_t sum_flattened(std::uint32_t n, std::size_t chunk) {
+    std::uint64_t sum = 0;
+    for (auto v: chunked(n, chunk) | co::views::flatten) sum += v;
+    return sum;
+}
+
+template<class F>
+std::uint64_t timed(const char* name, std::size_t chunk, std::uint32_t n, F f) {
+    auto start = clock_type::now();
+    auto sum = f();
+    auto ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    std::printf("%-12s %8zu %12.2f\n", name, chunk, ns / n);
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    std::uint32_t n = (argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 32) * 1'000'000u;
+    std::printf("%-12s %8s %12s\n", "consumer", "chunk", "ns/element");
+    auto expected = timed("per element", 1, n, [&] { return sum_elements(n); });
+    bool ok = true;
+    for (std::size_t chunk: {16, 256, 4096}) {
+        ok &= timed("spans", chunk, n, [&] { return sum_chunks(n, chunk); }) == expected;
+        ok &= timed("flatten", chunk, n, [&] { return sum_flattened(n, chunk); }) == expected;
+    }
+    if (!ok) {
+        std::printf("checksum mismatch\n");
+        return 1;
+    }
+    return 0;
+}
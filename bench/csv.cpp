@@ -0,0 +1,106 @@
+// parsing a generated multi-GB CSV file: `std::getline` per line and then per field
+// through a `std::stringstream`, against `co::csv_records` over a `co::mapped_file`.
+// both count records and fields and sum the field lengths. the file is written just
+// before, so both read it from the page cache
+//
+//   ./bench_csv [MiB] [path]
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+#include "co/csv.hpp"
+#include "co/mapped_file.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+struct totals {
+    std::uint64_t records = 0;
+    std::uint64_t fields = 0;
+    std::uint64_t bytes = 0;
+};
+
+// a quoted field with a delimiter in every fourth row, which the naive parser splits
+std::size_t write_file(const std::string& path, std::size_t mib) {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) throw std::system_error(errno, std::system_category(), "fopen " + path);
+    std::string row;
+    std::size_t written = 0;
+    for (std::uint64_t i = 0; written < (mib << 20); ++i) {
+        row = std::to_string(i * 7919 % 1000003) + ",user_" + std::to_string(i % 50000) + ",";
+        row += i % 4 ? "Smith" : "\"Smith, John\"";
+        row += ',';
+        row += std::to_string(i % 1000) + "." + std::to_string(i % 97) + ",2024-01-";
+        row += std::to_string(10 + i % 19) + "T12:34:56Z,some free text for row " + std::to_string(i) + "\n";
+        if (std::fwrite(row.data(), 1, row.size(), f) != row.size()) break;
+        written += row.size();
+    }
+    // a short write or a failed flush: the disk is full, or the file went away
+    if (std::ferror(f) | std::fclose(f)) {
+        ::unlink(path.c_str());
+        throw std::system_error(errno, std::system_category(), "write " + path);
+    }
+    return written;
+}
+
+totals naive(const std::string& path) {
+    totals t;
+    std::ifstream in{path};
+    std::string line, field;
+    while (std::getline(in, line)) {
+        std::stringstream ss{line};
+        while (std::getline(ss, field, ',')) {
+            ++t.fields;
+            t.bytes += field.size();
+        }
+        ++t.records;
+    }
+    return t;
+}
+
+totals mapped(const std::string& path) {
+    totals t;
+    co::mapped_file in{path};
+    for (auto fields: co::csv_records(in.text())) {
+        for (auto f: fields) t.bytes += f.size();
+        t.fields += fields.size();
+        ++t.records;
+    }
+    return t;
+}
+
+template<class F>
+void report(const char* name, std::size_t size, F parse) {
+    auto start = clock_type::now();
+    totals t = parse();
+    auto s = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-28s %7.2f s %8.0f MB/s %11llu records %11llu fields %12llu field bytes\n", name, s,
+                double(size) / s / 1e6, static_cast<unsigned long long>(t.records),
+                static_cast<unsigned long long>(t.fields), static_cast<unsigned long long>(t.bytes));
+}
+
+int main(int argc, char** argv) {
+    std::size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2048;
+    std::string path = argc > 2 ? argv[2] : "/tmp/co_bench.csv";
+
+    std::size_t size = 0;
+    try {
+        size = write_file(path, mib);
+    } catch (const std::system_error& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::printf("%.2f GB\n", double(size) / 1e9);
+    report("getline + stringstream", size, [&] { return naive(path); });
+    report("csv_records + mapped_file", size, [&] { return mapped(path); });
+    ::unlink(path.c_str());
+    return 0;
+}
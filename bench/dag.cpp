@@ -0,0 +1,159 @@
+// a random build-like graph: every node depends on one to three of the 64 nodes declared
+// just before it and waits 0.1 to 2 ms, a few of them 10 ms, the way a compile step waits
+// on a subprocess. run layer by layer, one `when_all` per depth, and as a `co::dag`. then
+// the same graph with empty nodes, for the cost of a node. both check that every node saw
+// the same inputs
+//
+//   ./bench_dag [nodes] [seed]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "co/combinators.hpp"
+#include "co/dag.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+struct graph_node {
+    std::vector<std::size_t> inputs;
+    std::chrono::microseconds cost;
+    std::size_t depth = 0;
+};
+
+std::vector<graph_node> make_graph(std::size_t n, unsigned seed) {
+    std::mt19937_64 rng{seed};
+    std::vector<graph_node> g(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        auto& node = g[i];
+        auto r = rng() % 1000;
+        node.cost = std::chrono::microseconds{r < 990 ? 100 + r * 2 : 10000};
+        if (i < 8) continue;
+        for (std::size_t k = 1 + rng() % 3; k > 0; --k) {
+            auto in = i - 1 - rng() % std::min<std::size_t>(i, 64);
+            if (std::find(node.inputs.begin(), node.inputs.end(), in) == node.inputs.end()) node.inputs.push_back(in);
+        }
+        for (auto in: node.inputs) node.depth = std::max(node.depth, g[in].depth + 1);
+    }
+    return g;
+}
+
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 31;
+    x *= 0x9e3779b97f4a7c15ull;
+    return x ^ (x >> 29);
+}
+
+co::task<std::uint64_t> work(std::size_t i, std::uint64_t in, std::chrono::microseconds cost) {
+    if (cost.count()) co_await co::sleep_for(cost);
+    co_return mix(in + i);
+}
+
+// every depth waits for the slowest node of the one before
+co::task<std::uint64_t> layered(const std::vector<graph_node>& g, bool empty) {
+    std::vector<std::uint64_t> out(g.size());
+    std::size_t depths = 0;
+    for (auto& node: g) depths = std::max(depths, node.depth + 1);
+    std::vector<std::vector<std::size_t>> layers(depths);
+    for (std::size_t i = 0; i < g.size(); ++i) layers[g[i].depth].push_back(i);
+    for (auto& layer: layers) {
+        std::vector<co::task<std::uint64_t>> tasks;
+        for (auto i: layer) {
+            std::uint64_t in = 0;
+            for (auto j: g[i].inputs) in += out[j];
+            tasks.push_back(work(i, in, empty ? std::chrono::microseconds{} : g[i].cost));
+        }
+        auto results = co_await co::when_all(std::move(tasks));
+        for (std::size_t k = 0; k < layer.size(); ++k) out[layer[k]] = results[k];
+    }
+    std::uint64_t sum = 0;
+    for (auto v: out) sum += v;
+    co_return sum;
+}
+
+// `add` takes its inputs as arguments, so a node with three of them sums two in a node of
+// its own first
+co::task<std::uint64_t> as_dag(const std::vector<graph_node>& g, bool empty) {
+    co::dag d;
+    std::vector<co::dag::node<std::uint64_t>> out;
+    out.reserve(g.size());
+    for (std::size_t i = 0; i < g.size(); ++i) {
+        auto cost = empty ? std::chrono::microseconds{} : g[i].cost;
+        auto& in = g[i].inputs;
+        auto run = [i, cost](std::uint64_t v) { return work(i, v, cost); };
+        auto sum = [](std::uint64_t a, std::uint64_t b) -> co::task<std::uint64_t> { co_return a + b; };
+        if (in.empty()) {
+            out.push_back(d.add([i, cost]() { return work(i, 0, cost); }));
+        } else if (in.size() == 1) {
+            out.push_back(d.add(run, out[in[0]]));
+        } else if (in.size() == 2) {
+            out.push_back(d.add([i, cost](std::uint64_t a, std::uint64_t b) { return work(i, a + b, cost); },
+                                out[in[0]], out[in[1]]));
+        } else {
+            auto folded = d.add(sum, out[in[0]], out[in[1]]);
+            out.push_back(d.add([i, cost](std::uint64_t a, std::uint64_t b) { return work(i, a + b, cost); },
+                                folded, out[in[2]]));
+        }
+    }
+    // every node is read below, so none may be moved into its last successor
+    for (auto n: out) d.keep(n);
+    co_await d.run();
+    std::uint64_t sum = 0;
+    for (auto n: out) sum += d.result(n);
+    co_return sum;
+}
+
+template<class F>
+double time_ms(co::executor& ex, std::uint64_t& checksum, F run) {
+    auto start = clock_type::now();
+    checksum = ex.block_on(run());
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000;
+    unsigned seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+    auto g = make_graph(n, seed);
+
+    // the longest chain of costs, which is as fast as any schedule can be
+    std::vector<double> finish(n);
+    double critical = 0, layers_ms = 0, serial = 0;
+    std::size_t depths = 0;
+    for (auto& node: g) depths = std::max(depths, node.depth + 1);
+    std::vector<double> layer_max(depths);
+    for (std::size_t i = 0; i < n; ++i) {
+        double start = 0;
+        for (auto in: g[i].inputs) start = std::max(start, finish[in]);
+        double cost = g[i].cost.count() / 1000.0;
+        finish[i] = start + cost;
+        critical = std::max(critical, finish[i]);
+        layer_max[g[i].depth] = std::max(layer_max[g[i].depth], cost);
+        serial += cost;
+    }
+    for (auto m: layer_max) layers_ms += m;
+
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    co::executor ex{cpus};
+    std::printf("%zu nodes, %zu deep, on %u workers: %.0f ms of waits, critical path %.1f ms, "
+                "sum of layer maxima %.1f ms\n",
+                n, depths, cpus, serial, critical, layers_ms);
+    std::printf("%-22s %10s %10s %12s %9s\n", "", "layered", "dag", "dag speedup", "same");
+    for (bool empty: {false, true}) {
+        std::uint64_t a = 0, b = 0;
+        double layered_ms = time_ms(ex, a, [&] { return layered(g, empty); });
+        double dag_ms = time_ms(ex, b, [&] { return as_dag(g, empty); });
+        if (empty) {
+            std::printf("%-22s %7.2f us %7.2f us %11.2fx %9s\n", "empty nodes, per node", layered_ms * 1000 / n,
+                        dag_ms * 1000 / n, layered_ms / dag_ms, a == b ? "yes" : "NO");
+        } else {
+            std::printf("%-22s %7.1f ms %7.1f ms %11.2fx %9s\n", "sleeping nodes", layered_ms, dag_ms,
+                        layered_ms / dag_ms, a == b ? "yes" : "NO");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,255 @@
+// the same fan-out in three styles: a request calls `fanout` operations on a local
+// service with simulated latency and sums the replies
+//
+//   ./bench_fanout [fanout] [clients] [requests per client] [latency ms]
+//
+// reports operations per second, heap bytes per in-flight operation and per-request
+// latency percentiles
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <latch>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+#include "co/combinators.hpp"
+#include "co/sync.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+// heap accounting: every allocation carries its size in a 16 byte header
+namespace heap {
+    std::atomic<long> live{0};
+    std::atomic<long> peak{0};
+
+    void reset() {
+        peak.store(live.load());
+    }
+}
+
+void* operator new(std::size_t n) {
+    auto* p = static_cast<std::size_t*>(std::malloc(n + 16));
+    if (!p) throw std::bad_alloc{};
+    *p = n;
+    auto now = heap::live.fetch_add(static_cast<long>(n), std::memory_order_relaxed) + static_cast<long>(n);
+    auto peak = heap::peak.load(std::memory_order_relaxed);
+    while (now > peak && !heap::peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+    return reinterpret_cast<char*>(p) + 16;
+}
+
+void operator delete(void* q) noexcept {
+    if (!q) return;
+    auto* p = reinterpret_cast<std::size_t*>(static_cast<char*>(q) - 16);
+    heap::live.fetch_sub(static_cast<long>(*p), std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* q, std::size_t) noexcept { operator delete(q); }
+
+struct config {
+    int fanout = 100;
+    int clients = 8;
+    int requests = 50;
+    std::chrono::milliseconds latency{1};
+};
+
+struct result {
+    const char* style;
+    double ops_per_sec;
+    long heap_per_op;
+    std::vector<double> latencies_us;
+};
+
+// --- coroutines ------------------------------------------------------------------------
+
+co::task<int> call(int x, std::chrono::milliseconds latency) {
+    co_await co::sleep_for(latency);
+    co_return x * 2;
+}
+
+co::task<long> request_co(const config& cfg) {
+    std::vector<co::task<int>> calls;
+    calls.reserve(static_cast<std::size_t>(cfg.fanout));
+    for (int i = 0; i < cfg.fanout; ++i) calls.push_back(call(i, cfg.latency));
+    long sum = 0;
+    for (auto v: co_await co::when_all(std::move(calls))) sum += v;
+    co_return sum;
+}
+
+co::task<> client_co(const config& cfg, std::vector<double>& latencies, co::async_latch& done) {
+    for (int r = 0; r < cfg.requests; ++r) {
+        auto start = clock_type::now();
+        co_await request_co(cfg);
+        latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - start).count());
+    }
+    done.count_down();
+}
+
+co::task<> run_co(const config& cfg, std::vector<std::vector<double>>& latencies) {
+    co::async_latch done{cfg.clients};
+    for (auto& l: latencies) co::executor::current()->spawn(client_co(cfg, l, done));
+    co_await done.wait();
+}
+
+// --- callbacks -------------------------------------------------------------------------
+
+// continuation-passing service: the reply arrives on the timer thread
+struct callback_service {
+    co::executor& ex;
+    std::chrono::milliseconds latency;
+
+    struct op : co::timer_node {
+        int x;
+        std::function<void(int)> done;
+    };
+
+    void call(int x, std::function<void(int)> done) {
+        auto* o = new op{};
+        o->x = x;
+        o->done = std::move(done);
+        o->fire = [](co::timer_node* n) {
+            auto* o = static_cast<op*>(n);
+            o->done(o->x * 2);
+            delete o;
+        };
+        ex.timers().arm(o, latency);
+    }
+};
+
+struct fanout_state {
+    std::atomic<int> remaining;
+    std::atomic<long> sum{0};
+    std::function<void(long)> done;
+};
+
+void request_cb(callback_service& svc, int fanout, std::function<void(long)> done) {
+    auto* s = new fanout_state{};
+    s->remaining = fanout;
+    s->done = std::move(done);
+    for (int i = 0; i < fanout; ++i) {
+        svc.call(i, [s](int v) {
+            s->sum.fetch_add(v, std::memory_order_relaxed);
+            if (s->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                s->done(s->sum.load());
+                delete s;
+            }
+        });
+    }
+}
+
+void client_cb(callback_service& svc, const config& cfg, int left, std::vector<double>& latencies,
+               std::latch& done) {
+    if (left == 0) {
+        done.count_down();
+        return;
+    }
+    auto start = clock_type::now();
+    request_cb(svc, cfg.fanout, [&svc, &cfg, left, &latencies, &done, start](long) {
+        latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - start).count());
+        client_cb(svc, cfg, left - 1, latencies, done);
+    });
+}
+
+// --- threads and futures ---------------------------------------------------------------
+
+long request_threads(const config& cfg) {
+    std::vector<std::future<int>> calls;
+    calls.reserve(static_cast<std::size_t>(cfg.fanout));
+    for (int i = 0; i < cfg.fanout; ++i) {
+        calls.push_back(std::async(std::launch::async, [i, &cfg] {
+            std::this_thread::sleep_for(cfg.latency);
+            return i * 2;
+        }));
+    }
+    long sum = 0;
+    for (auto& f: calls) sum += f.get();
+    return sum;
+}
+
+// --- driver ----------------------------------------------------------------------------
+
+template<class F>
+result measure(const char* style, const config& cfg, F run) {
+    std::vector<std::vector<double>> latencies(static_cast<std::size_t>(cfg.clients));
+    for (auto& l: latencies) l.reserve(static_cast<std::size_t>(cfg.requests));
+    heap::reset();
+    auto base = heap::live.load();
+    auto start = clock_type::now();
+    run(latencies);
+    auto seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    result r{style, 0, 0, {}};
+    for (auto& l: latencies) r.latencies_us.insert(r.latencies_us.end(), l.begin(), l.end());
+    std::sort(r.latencies_us.begin(), r.latencies_us.end());
+    double ops = double(cfg.clients) * cfg.requests * cfg.fanout;
+    r.ops_per_sec = ops / seconds;
+    r.heap_per_op = (heap::peak.load() - base) / (long(cfg.clients) * cfg.fanout);
+    return r;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    auto i = static_cast<std::size_t>(p * double(sorted.size() - 1));
+    return sorted[i];
+}
+
+int main(int argc, char** argv) {
+    config cfg;
+    if (argc > 1) cfg.fanout = std::atoi(argv[1]);
+    if (argc > 2) cfg.clients = std::atoi(argv[2]);
+    if (argc > 3) cfg.requests = std::atoi(argv[3]);
+    if (argc > 4) cfg.latency = std::chrono::milliseconds{std::atoi(argv[4])};
+
+    std::vector<result> results;
+    {
+        co::executor ex;
+        results.push_back(measure("co::task", cfg, [&](auto& latencies) {
+            ex.block_on(run_co(cfg, latencies));
+        }));
+
+        callback_service svc{ex, cfg.latency};
+        results.push_back(measure("callbacks", cfg, [&](auto& latencies) {
+            std::latch done{cfg.clients};
+            for (auto& l: latencies) client_cb(svc, cfg, cfg.requests, l, done);
+            done.wait();
+        }));
+    }
+    results.push_back(measure("threads+futures", cfg, [&](auto& latencies) {
+        std::vector<std::thread> clients;
+        for (auto& l: latencies) {
+            clients.emplace_back([&cfg, &l] {
+                for (int r = 0; r < cfg.requests; ++r) {
+                    auto start = clock_type::now();
+                    request_threads(cfg);
+                    l.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - start).count());
+                }
+            });
+        }
+        for (auto& t: clients) t.join();
+    }));
+
+    pthread_attr_t attr;
+    std::size_t stack = 0;
+    pthread_attr_init(&attr);
+    pthread_attr_getstacksize(&attr, &stack);
+    pthread_attr_destroy(&attr);
+
+    std::printf("fanout %d, %d clients, %d requests each, %lldms latency\n", cfg.fanout, cfg.clients,
+                cfg.requests, static_cast<long long>(cfg.latency.count()));
+    std::printf("%-16s %12s %10s %10s %10s %10s\n", "style", "ops/s", "heap B/op", "p50 us", "p99 us", "p999 us");
+    for (auto& r: results) {
+        std::printf("%-16s %12.0f %10ld %10.0f %10.0f %10.0f\n", r.style, r.ops_per_sec, r.heap_per_op,
+                    percentile(r.latencies_us, 0.5), percentile(r.latencies_us, 0.99),
+                    percentile(r.latencies_us, 0.999));
+    }
+    std::printf("threads also reserve a %zu KiB stack per in-flight op\n", stack / 1024);
+    return 0;
+}
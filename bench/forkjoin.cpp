@@ -0,0 +1,354 @@
+// classic fork-join kernels, each written serially and as `co::task`s on the
+// work-stealing executor, forked two ways: with `when_all`, which queues every child
+// (child stealing), and with `co::fork` / `co::join`, which runs the child at once and
+// leaves the parent's continuation to be stolen
+//
+//   ./bench_forkjoin [max workers]
+//
+// for 1..N workers reports the time, the speedup over one worker and the overhead of
+// the one-worker run over the serial code; that overhead is what the scheduler costs.
+// `frames` is coroutine frames allocated per run
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "co/combinators.hpp"
+#include "co/fork.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+template<class T>
+co::task<std::vector<T>> fork2(co::task<T> a, co::task<T> b) {
+    std::vector<co::task<T>> both;
+    both.push_back(std::move(a));
+    both.push_back(std::move(b));
+    co_return co_await co::when_all(std::move(both));
+}
+
+co::task<> fork2(co::task<> a, co::task<> b) {
+    std::vector<co::task<>> both;
+    both.push_back(std::move(a));
+    both.push_back(std::move(b));
+    co_await co::when_all(std::move(both));
+}
+
+// --- fib -------------------------------------------------------------------------------
+
+constexpr int fib_n = 35;
+constexpr int fib_cutoff = 18;
+
+long fib_serial(int n) { return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2); }
+
+co::task<long> fib(int n) {
+    if (n < fib_cutoff) co_return fib_serial(n);
+    auto r = co_await fork2(fib(n - 1), fib(n - 2));
+    co_return r[0] + r[1];
+}
+
+co::task<long> fib_fork(int n) {
+    if (n < fib_cutoff) co_return fib_serial(n);
+    long a = 0;
+    co_await co::fork(fib_fork(n - 1), a);
+    long b = co_await fib_fork(n - 2);
+    co_await co::join();
+    co_return a + b;
+}
+
+// --- mergesort -------------------------------------------------------------------------
+
+constexpr std::size_t sort_n = 1 << 22;
+constexpr std::size_t sort_cutoff = 1 << 14;
+
+void merge_halves(std::uint32_t* a, std::uint32_t* tmp, std::size_t n) {
+    std::merge(a, a + n / 2, a + n / 2, a + n, tmp);
+    std::copy(tmp, tmp + n, a);
+}
+
+void mergesort_serial(std::uint32_t* a, std::uint32_t* tmp, std::size_t n) {
+    if (n <= sort_cutoff) {
+        std::sort(a, a + n);
+        return;
+    }
+    mergesort_serial(a, tmp, n / 2);
+    mergesort_serial(a + n / 2, tmp + n / 2, n - n / 2);
+    merge_halves(a, tmp, n);
+}
+
+co::task<> mergesort(std::uint32_t* a, std::uint32_t* tmp, std::size_t n) {
+    if (n <= sort_cutoff) {
+        std::sort(a, a + n);
+        co_return;
+    }
+    co_await fork2(mergesort(a, tmp, n / 2), mergesort(a + n / 2, tmp + n / 2, n - n / 2));
+    merge_halves(a, tmp, n);
+}
+
+co::task<> mergesort_fork(std::uint32_t* a, std::uint32_t* tmp, std::size_t n) {
+    if (n <= sort_cutoff) {
+        std::sort(a, a + n);
+        co_return;
+    }
+    co_await co::fork(mergesort_fork(a, tmp, n / 2));
+    co_await mergesort_fork(a + n / 2, tmp + n / 2, n - n / 2);
+    co_await co::join();
+    merge_halves(a, tmp, n);
+}
+
+std::vector<std::uint32_t> sort_input() {
+    std::vector<std::uint32_t> v(sort_n);
+    std::mt19937 rng{42};
+    for (auto& x: v) x = rng();
+    return v;
+}
+
+// --- n-queens --------------------------------------------------------------------------
+
+constexpr int queens_n = 12;
+constexpr int queens_cutoff = 3;  // rows placed in parallel before going serial
+
+long queens_serial(int n, int row, unsigned cols, unsigned d1, unsigned d2) {
+    if (row == n) return 1;
+    long count = 0;
+    for (unsigned free = ~(cols | d1 | d2) & ((1u << n) - 1); free; free &= free - 1) {
+        unsigned bit = free & -free;
+        count += queens_serial(n, row + 1, cols | bit, (d1 | bit) << 1, (d2 | bit) >> 1);
+    }
+    return count;
+}
+
+co::task<long> queens(int n, int row, unsigned cols, unsigned d1, unsigned d2) {
+    if (row >= queens_cutoff) co_return queens_serial(n, row, cols, d1, d2);
+    std::vector<co::task<long>> branches;
+    for (unsigned free = ~(cols | d1 | d2) & ((1u << n) - 1); free; free &= free - 1) {
+        unsigned bit = free & -free;
+        branches.push_back(queens(n, row + 1, cols | bit, (d1 | bit) << 1, (d2 | bit) >> 1));
+    }
+    long count = 0;
+    for (long c: co_await co::when_all(std::move(branches))) count += c;
+    co_return count;
+}
+
+co::task<long> queens_fork(int n, int row, unsigned cols, unsigned d1, unsigned d2) {
+    if (row >= queens_cutoff) co_return queens_serial(n, row, cols, d1, d2);
+    long counts[32] = {};
+    int i = 0;
+    for (unsigned free = ~(cols | d1 | d2) & ((1u << n) - 1); free; free &= free - 1) {
+        unsigned bit = free & -free;
+        co_await co::fork(queens_fork(n, row + 1, cols | bit, (d1 | bit) << 1, (d2 | bit) >> 1), counts[i++]);
+    }
+    co_await co::join();
+    long count = 0;
+    for (int k = 0; k < i; ++k) count += counts[k];
+    co_return count;
+}
+
+// --- matrix multiply -------------------------------------------------------------------
+
+constexpr std::size_t mat_n = 512;
+constexpr std::size_t mat_cutoff = 64;
+
+// a square block inside a row-major `mat_n` x `mat_n` matrix
+struct block {
+    double* p;
+    std::size_t n;
+
+    double& at(std::size_t r, std::size_t c) const { return p[r * mat_n + c]; }
+
+    block quad(int r, int c) const { return {p + (r * mat_n + c) * (n / 2), n / 2}; }
+};
+
+void matmul_base(block c, block a, block b) {
+    for (std::size_t i = 0; i < c.n; ++i) {
+        for (std::size_t k = 0; k < c.n; ++k) {
+            double x = a.at(i, k);
+            for (std::size_t j = 0; j < c.n; ++j) c.at(i, j) += x * b.at(k, j);
+        }
+    }
+}
+
+// C += A * B by quadrants: the two products landing in the same quadrant of C run one
+// after the other, the four quadrants in parallel
+void matmul_serial(block c, block a, block b) {
+    if (c.n <= mat_cutoff) return matmul_base(c, a, b);
+    for (int k = 0; k < 2; ++k) {
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) matmul_serial(c.quad(i, j), a.quad(i, k), b.quad(k, j));
+        }
+    }
+}
+
+co::task<> matmul(block c, block a, block b) {
+    if (c.n <= mat_cutoff) {
+        matmul_base(c, a, b);
+        co_return;
+    }
+    for (int k = 0; k < 2; ++k) {
+        std::vector<co::task<>> quads;
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) quads.push_back(matmul(c.quad(i, j), a.quad(i, k), b.quad(k, j)));
+        }
+        co_await co::when_all(std::move(quads));
+    }
+}
+
+co::task<> matmul_fork(block c, block a, block b) {
+    if (c.n <= mat_cutoff) {
+        matmul_base(c, a, b);
+        co_return;
+    }
+    for (int k = 0; k < 2; ++k) {
+        co_await co::fork(matmul_fork(c.quad(0, 0), a.quad(0, k), b.quad(k, 0)));
+        co_await co::fork(matmul_fork(c.quad(0, 1), a.quad(0, k), b.quad(k, 1)));
+        co_await co::fork(matmul_fork(c.quad(1, 0), a.quad(1, k), b.quad(k, 0)));
+        co_await matmul_fork(c.quad(1, 1), a.quad(1, k), b.quad(k, 1));
+        co_await co::join();
+    }
+}
+
+struct matrices {
+    std::vector<double> a = std::vector<double>(mat_n * mat_n);
+    std::vector<double> b = std::vector<double>(mat_n * mat_n);
+    std::vector<double> c = std::vector<double>(mat_n * mat_n);
+
+    matrices() {
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            a[i] = double(i % 7) - 3;
+            b[i] = double(i % 5) - 2;
+        }
+    }
+
+    double checksum() const {
+        double s = 0;
+        for (double x: c) s += x;
+        return s;
+    }
+};
+
+// --- driver ----------------------------------------------------------------------------
+
+enum class style { serial, when_all, fork };
+
+struct result {
+    double checksum;
+    double seconds;
+    std::uint64_t frames = 0;
+};
+
+template<class F>
+result timed(F f) {
+    auto frames = co::runtime_stats::collect().frames_created;
+    auto start = clock_type::now();
+    double checksum = f();
+    auto seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    return {checksum, seconds, co::runtime_stats::collect().frames_created - frames};
+}
+
+struct kernel {
+    const char* name;
+    // setup is outside the timed part; `ex` is null for `style::serial`
+    std::function<result(co::executor* ex, style s)> run;
+};
+
+// best of three
+result measure(const kernel& k, co::executor* ex, style s) {
+    auto best = k.run(ex, s);
+    for (int i = 0; i < 2; ++i) {
+        auto r = k.run(ex, s);
+        if (r.seconds < best.seconds) best = r;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    std::size_t max_workers = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1]))
+                                       : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<kernel> kernels{
+            {"fib", [](co::executor* ex, style s) {
+                 return timed([&] {
+                     switch (s) {
+                         case style::serial: return double(fib_serial(fib_n));
+                         case style::when_all: return double(ex->block_on(fib(fib_n)));
+                         default: return double(ex->block_on(fib_fork(fib_n)));
+                     }
+                 });
+             }},
+            {"mergesort", [](co::executor* ex, style s) {
+                 auto v = sort_input();
+                 std::vector<std::uint32_t> tmp(v.size());
+                 auto r = timed([&] {
+                     switch (s) {
+                         case style::serial: mergesort_serial(v.data(), tmp.data(), v.size()); break;
+                         case style::when_all: ex->block_on(mergesort(v.data(), tmp.data(), v.size())); break;
+                         default: ex->block_on(mergesort_fork(v.data(), tmp.data(), v.size()));
+                     }
+                     return 0.0;
+                 });
+                 r.checksum = double(std::is_sorted(v.begin(), v.end()));
+                 return r;
+             }},
+            {"nqueens", [](co::executor* ex, style s) {
+                 return timed([&] {
+                     switch (s) {
+                         case style::serial: return double(queens_serial(queens_n, 0, 0, 0, 0));
+                         case style::when_all: return double(ex->block_on(queens(queens_n, 0, 0, 0, 0)));
+                         default: return double(ex->block_on(queens_fork(queens_n, 0, 0, 0, 0)));
+                     }
+                 });
+             }},
+            {"matmul", [](co::executor* ex, style s) {
+                 matrices m;
+                 block a{m.a.data(), mat_n}, b{m.b.data(), mat_n}, c{m.c.data(), mat_n};
+                 auto r = timed([&] {
+                     switch (s) {
+                         case style::serial: matmul_serial(c, a, b); break;
+                         case style::when_all: ex->block_on(matmul(c, a, b)); break;
+                         default: ex->block_on(matmul_fork(c, a, b));
+                     }
+                     return 0.0;
+                 });
+                 r.checksum = m.checksum();
+                 return r;
+             }},
+    };
+
+    std::printf("fib(%d) cutoff %d, mergesort %zu cutoff %zu, %d-queens parallel to row %d, "
+                "matmul %zu cutoff %zu\n\n",
+                fib_n, fib_cutoff, sort_n, sort_cutoff, queens_n, queens_cutoff, mat_n, mat_cutoff);
+    std::printf("%-10s %-9s %8s %10s %9s %9s %9s\n", "kernel", "style", "workers", "ms", "speedup", "overhead",
+                "frames");
+    bool ok = true;
+    for (auto& k: kernels) {
+        auto serial = measure(k, nullptr, style::serial);
+        std::printf("%-10s %-9s %8s %10.1f\n", k.name, "serial", "", serial.seconds * 1e3);
+        for (auto s: {style::when_all, style::fork}) {
+            auto name = s == style::when_all ? "when_all" : "fork";
+            double one = 0;
+            for (std::size_t w = 1; w <= max_workers; ++w) {
+                co::executor ex{w};
+                auto r = measure(k, &ex, s);
+                ok &= r.checksum == serial.checksum;
+                if (w == 1) {
+                    one = r.seconds;
+                    std::printf("%-10s %-9s %8zu %10.1f %8.2fx %8.1f%% %9llu\n", k.name, name, w, r.seconds * 1e3,
+                                1.0, (one / serial.seconds - 1) * 100, static_cast<unsigned long long>(r.frames));
+                } else {
+                    std::printf("%-10s %-9s %8zu %10.1f %8.2fx %9s %9llu\n", k.name, name, w, r.seconds * 1e3,
+                                one / r.seconds, "", static_cast<unsigned long long>(r.frames));
+                }
+            }
+        }
+    }
+    if (!ok) {
+        std::printf("checksum mismatch\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+// wake-up latency vs idle CPU for a few `co::idle_policy` settings: a thread outside the
+// pool submits one task at a time, with a pause in between that lets the workers go idle
+//
+//   ./bench_idle [workers] [wakes] [gap us]
+//
+// reports the time from `spawn` to the task running, the CPU the process burned per
+// wake, and how often a worker actually went to sleep on the futex
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#include "co/executor.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+co::task<> ping(clock_type::time_point sent, double& latency_us) {
+    latency_us = std::chrono::duration<double, std::micro>(clock_type::now() - sent).count();
+    co_return;
+}
+
+double cpu_seconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+}
+
+struct config {
+    std::size_t workers = std::thread::hardware_concurrency();
+    int wakes = 2000;
+    std::chrono::microseconds gap{200};
+};
+
+void measure(const char* name, const config& cfg, co::idle_policy policy) {
+    std::vector<double> latencies(static_cast<std::size_t>(cfg.wakes));
+    co::executor ex{cfg.workers, policy};
+    auto parks = ex.stats().parks;
+    auto cpu = cpu_seconds();
+    auto start = clock_type::now();
+    for (auto& l: latencies) {
+        std::this_thread::sleep_for(cfg.gap);
+        ex.block_on(ping(clock_type::now(), l));
+    }
+    auto wall = std::chrono::duration<double>(clock_type::now() - start).count();
+    cpu = cpu_seconds() - cpu;
+    parks = ex.stats().parks - parks;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&](double p) { return latencies[static_cast<std::size_t>(p * double(latencies.size() - 1))]; };
+    std::printf("%-22s %8.1f %8.1f %10.1f %8.0f%% %10.2f\n", name, at(0.5), at(0.99), cpu / cfg.wakes * 1e6,
+                cpu / wall * 100, double(parks) / cfg.wakes);
+}
+
+int main(int argc, char** argv) {
+    config cfg;
+    if (argc > 1) cfg.workers = static_cast<std::size_t>(std::atoi(argv[1]));
+    if (argc > 2) cfg.wakes = std::atoi(argv[2]);
+    if (argc > 3) cfg.gap = std::chrono::microseconds{std::atoi(argv[3])};
+
+    std::printf("%zu workers, %d wakes, %lldus apart\n", cfg.workers, cfg.wakes,
+                static_cast<long long>(cfg.gap.count()));
+    std::printf("%-22s %8s %8s %10s %9s %10s\n", "policy", "p50 us", "p99 us", "cpu us/op", "cpu", "parks/op");
+    measure("park at once", cfg, {.spin_rounds = 0});
+    measure("spin 8 x <=16", cfg, {.spin_rounds = 8, .max_pause = 16});
+    measure("spin 12 x <=64", cfg, {});
+    measure("spin 64 x <=256", cfg, {.spin_rounds = 64, .max_pause = 256});
+    measure("spin 4096 x <=1024", cfg, {.spin_rounds = 4096, .max_pause = 1024});
+    return 0;
+}
@@ -0,0 +1,52 @@
+// nested task chains: every level spawns the next onto the executor and waits on a latch
+// for it, so each completion wakes exactly one awaiter on the same worker. compares
+// re-enqueueing that awaiter with resuming it inline, for several depth limits
+//
+//   ./bench_inline [workers] [chain length] [chains]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "co/sync.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+co::task<> level(int depth, co::async_latch& parent) {
+    if (depth > 0) {
+        co::async_latch done{1};
+        co::executor::current()->spawn(level(depth - 1, done));
+        co_await done.wait();
+    }
+    // arriving from a suspension point is what lets the waiter run inline
+    co_await parent.arrive_and_wait();
+}
+
+co::task<> chain(int length) {
+    co::async_latch done{1};
+    co::executor::current()->spawn(level(length, done));
+    co_await done.wait();
+}
+
+int main(int argc, char** argv) {
+    std::size_t workers = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 1;
+    int length = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int chains = argc > 3 ? std::atoi(argv[3]) : 200;
+
+    std::printf("%zu workers, %d chains of %d levels\n", workers, chains, length);
+    std::printf("%-12s %10s %10s\n", "inline depth", "ns/level", "inlined");
+    for (std::size_t limit: {0, 1, 4, 16, 64}) {
+        co::executor ex{workers};
+        ex.max_inline_depth(limit);
+        ex.block_on(chain(length));  // warm up
+        auto before = ex.stats();
+        auto start = clock_type::now();
+        for (int c = 0; c < chains; ++c) ex.block_on(chain(length));
+        auto ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+        auto after = ex.stats();
+        double levels = double(chains) * (length + 1);
+        std::printf("%-12zu %10.1f %9.0f%%\n", limit, ns / levels,
+                    double(after.inline_resumes - before.inline_resumes) / levels * 100);
+    }
+    return 0;
+}
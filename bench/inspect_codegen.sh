@@ -0,0 +1,29 @@
+#!/bin/sh
+# disassembles the two consumer loops of bench_parser and reports, for each, how many
+# calls it makes and whether any of them is the indirect jump into a coroutine's
+# resume function (i.e. the generator body was not inlined into the loop)
+#
+#   bench/inspect_codegen.sh path/to/bench_parser
+set -eu
+
+bin=${1:?usage: $0 path/to/bench_parser}
+asm=$(objdump -d --no-show-raw-insn -C "$bin")
+
+for fn in consume_coroutine consume_state_machine; do
+    body=$(printf '%s\n' "$asm" | awk -v fn="$fn" '
+        # the hot body only, not the [clone .cold] part
+        $0 ~ "^[0-9a-f]+ <" fn "\\(" && $0 !~ /clone/ { inside = 1; next }
+        inside && /^$/ { exit }
+        inside { print }')
+    insns=$(printf '%s\n' "$body" | grep -c ':' || true)
+    calls=$(printf '%s\n' "$body" | grep -cE '\s(call|jmp)\s' || true)
+    indirect=$(printf '%s\n' "$body" | grep -cE '\s(call|jmp)\s+\*' || true)
+    actor=$(printf '%s\n' "$body" | grep -cE '(actor|resume)' || true)
+    echo "$fn: $insns instructions, $calls call/jmp, $indirect of them indirect"
+    if [ "$indirect" -gt 0 ] || [ "$actor" -gt 0 ]; then
+        echo "  resume is NOT inlined: every token goes through the frame's resume pointer"
+    else
+        echo "  no indirect calls: the loop body is fully inlined"
+    fi
+    printf '%s\n' "$body" | grep -E '\s(call|jmp)\s+\*|actor|resume' | sed 's/^/    /' || true
+done
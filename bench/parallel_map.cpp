@@ -0,0 +1,65 @@
+// a CPU-heavy transform whose cost varies 40x from item to item, run in a plain loop and
+// through `co::parallel_map` with 1..16 instances on an executor with a worker per cpu.
+// checks that the results come out in source order, and reports the time per item next
+// to the serial loop's
+//
+//   ./bench_parallel_map [items] [window]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "co/parallel_map.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+// 1 to 40 rounds of 1000 xorshift steps
+std::uint64_t transform(std::uint64_t i) {
+    std::uint64_t x = i * 0x9e3779b97f4a7c15ull + 1;
+    auto rounds = 1 + (x >> 7) % 40;
+    for (std::uint64_t r = 0; r < rounds * 1000; ++r) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+co::async_generator<std::uint64_t> items(std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i) co_yield i;
+}
+
+// depends on the order, so it only matches the serial loop's if every result came in place
+co::task<std::uint64_t> run(std::uint64_t n, std::size_t instances, std::size_t window) {
+    std::uint64_t checksum = 0;
+    auto out = co::parallel_map(items(n), transform, {.instances = instances, .window = window});
+    while (auto* v = co_await out.next()) checksum = checksum * 31 + *v;
+    co_return checksum;
+}
+
+int main(int argc, char** argv) {
+    std::uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    std::size_t window = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+    auto start = clock_type::now();
+    std::uint64_t serial = 0;
+    for (std::uint64_t i = 0; i < n; ++i) serial = serial * 31 + transform(i);
+    auto serial_us = std::chrono::duration<double, std::micro>(clock_type::now() - start).count() / double(n);
+
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    co::executor ex{cpus};
+    std::printf("%llu items on %u workers, serial %.2f us per item\n", static_cast<unsigned long long>(n), cpus,
+                serial_us);
+    std::printf("%-10s %12s %9s %8s\n", "instances", "us per item", "speedup", "ordered");
+    for (std::size_t instances: {1, 2, 4, 8, 16}) {
+        start = clock_type::now();
+        auto checksum = ex.block_on(run(n, instances, window));
+        auto us = std::chrono::duration<double, std::micro>(clock_type::now() - start).count() / double(n);
+        std::printf("%-10zu %12.2f %8.2fx %8s\n", instances, us, serial_us / us,
+                    checksum == serial ? "yes" : "NO");
+    }
+    return 0;
+}
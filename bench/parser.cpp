@@ -0,0 +1,213 @@
+// the same tokenizer twice: as a coroutine that `co_yield`s every token, and as the
+// hand-written `switch` state machine a compiler would lower it to
+//
+//   ./bench_parser [megabytes]
+//
+// reports time, cycles and (where perf counters are available) instructions per token,
+// plus the coroutine frame size. `bench/inspect_codegen.sh` disassembles both consumer
+// loops to show whether the coroutine's resume was inlined
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "co/generator.hpp"
+
+enum class kind : std::uint8_t { number, ident, punct };
+
+struct token {
+    kind k;
+    std::string_view text;
+};
+
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static bool is_alpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+
+static bool is_space(char c) { return c == ' ' || c == '\n' || c == '\t'; }
+
+co::generator<token> tokenize(std::string_view s) {
+    std::size_t i = 0;
+    while (i < s.size()) {
+        char c = s[i];
+        if (is_space(c)) {
+            ++i;
+        } else if (is_digit(c)) {
+            auto start = i;
+            while (i < s.size() && is_digit(s[i])) ++i;
+            co_yield token{kind::number, s.substr(start, i - start)};
+        } else if (is_alpha(c)) {
+            auto start = i;
+            while (i < s.size() && (is_alpha(s[i]) || is_digit(s[i]))) ++i;
+            co_yield token{kind::ident, s.substr(start, i - start)};
+        } else {
+            co_yield token{kind::punct, s.substr(i++, 1)};
+        }
+    }
+}
+
+// what the coroutine above amounts to: the locals move into the struct and every
+// `co_yield` becomes a `return true` plus a state to continue from
+struct tokenizer {
+    std::string_view s;
+    std::size_t i = 0;
+    std::size_t start = 0;
+    enum { scan, in_number, in_ident } state = scan;
+
+    bool next(token& out) {
+        while (i < s.size()) {
+            char c = s[i];
+            switch (state) {
+                case scan:
+                    if (is_space(c)) {
+                        ++i;
+                    } else if (is_digit(c)) {
+                        start = i++;
+                        state = in_number;
+                    } else if (is_alpha(c)) {
+                        start = i++;
+                        state = in_ident;
+                    } else {
+                        out = {kind::punct, s.substr(i++, 1)};
+                        return true;
+                    }
+                    break;
+                case in_number:
+                    if (is_digit(c)) {
+                        ++i;
+                        break;
+                    }
+                    state = scan;
+                    out = {kind::number, s.substr(start, i - start)};
+                    return true;
+                case in_ident:
+                    if (is_alpha(c) || is_digit(c)) {
+                        ++i;
+                        break;
+                    }
+                    state = scan;
+                    out = {kind::ident, s.substr(start, i - start)};
+                    return true;
+            }
+        }
+        if (state == scan) return false;
+        out = {state == in_number ? kind::number : kind::ident, s.substr(start, i - start)};
+        state = scan;
+        return true;
+    }
+};
+
+struct totals {
+    std::size_t tokens = 0;
+    std::size_t checksum = 0;
+};
+
+__attribute__((noinline)) totals consume_coroutine(std::string_view s) {
+    totals t;
+    for (auto& tok: tokenize(s)) {
+        ++t.tokens;
+        t.checksum += static_cast<std::size_t>(tok.k) + tok.text.size();
+    }
+    return t;
+}
+
+__attribute__((noinline)) totals consume_state_machine(std::string_view s) {
+    totals t;
+    tokenizer tz{s};
+    token tok;
+    while (tz.next(tok)) {
+        ++t.tokens;
+        t.checksum += static_cast<std::size_t>(tok.k) + tok.text.size();
+    }
+    return t;
+}
+
+// user-space instruction counter; -1 when perf events are unavailable (e.g. in a VM)
+struct instruction_counter {
+    int fd = -1;
+
+    instruction_counter() {
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~instruction_counter() {
+        if (fd >= 0) close(fd);
+    }
+
+    void start() {
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    long long stop() {
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long n = 0;
+        if (read(fd, &n, sizeof(n)) != sizeof(n)) return -1;
+        return n;
+    }
+};
+
+template<class F>
+totals report(const char* name, std::string_view input, F consume) {
+    instruction_counter instructions;
+    consume(input);  // warm up
+    instructions.start();
+    auto t0 = std::chrono::steady_clock::now();
+    auto c0 = __rdtsc();
+    auto t = consume(input);
+    auto c1 = __rdtsc();
+    auto t1 = std::chrono::steady_clock::now();
+    auto n = instructions.stop();
+
+    double tokens = static_cast<double>(t.tokens);
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-14s %10.2f %10.2f ", name, ns / tokens, static_cast<double>(c1 - c0) / tokens);
+    if (n >= 0) {
+        std::printf("%10.2f\n", static_cast<double>(n) / tokens);
+    } else {
+        std::printf("%10s\n", "n/a");
+    }
+    return t;
+}
+
+int main(int argc, char** argv) {
+    std::size_t mb = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 16;
+    std::string input;
+    const std::string_view line = "total = price * 1024 + tax_2 - (discount / 3);\n";
+    while (input.size() < mb << 20) input += line;
+
+    {
+        auto before = co::runtime_stats::collect().live_frame_bytes();
+        auto g = tokenize(input);
+        std::printf("coroutine frame: %llu bytes\n",
+                    static_cast<unsigned long long>(co::runtime_stats::collect().live_frame_bytes() - before));
+    }
+
+    std::printf("%-14s %10s %10s %10s\n", "", "ns/token", "tsc/token", "insn/token");
+    auto a = report("coroutine", input, consume_coroutine);
+    auto b = report("state machine", input, consume_state_machine);
+    if (a.tokens != b.tokens || a.checksum != b.checksum) {
+        std::printf("mismatch: %zu/%zu tokens, checksum %zu/%zu\n", a.tokens, b.tokens, a.checksum, b.checksum);
+        return 1;
+    }
+    std::printf("%zu tokens\n", a.tokens);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// many idle-timeout style timers: every task sleeps a random 50-150 ms a few times over.
+// for several slacks reports how often the timer thread woke up, timers fired per wakeup,
+// how late they fired and the process CPU time; then the cost of an arm + cancel pair
+// with the precise and with the coarse clock
+//
+//   ./bench_timers [timers] [rounds]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "co/sync.hpp"
+
+using namespace std::chrono_literals;
+using clock_type = std::chrono::steady_clock;
+
+double cpu_seconds() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    auto tv = [](timeval t) { return double(t.tv_sec) + double(t.tv_usec) * 1e-6; };
+    return tv(ru.ru_utime) + tv(ru.ru_stime);
+}
+
+co::task<> sleeper(unsigned seed, int rounds, clock_type::duration slack, std::vector<double>& late_ms,
+                   co::async_latch& done) {
+    std::minstd_rand rng{seed};
+    std::uniform_int_distribution<int> ms{50, 150};
+    for (int r = 0; r < rounds; ++r) {
+        auto d = std::chrono::milliseconds{ms(rng)};
+        auto start = clock_type::now();
+        co_await co::sleep_for(d, slack);
+        late_ms[seed * rounds + r] = std::chrono::duration<double, std::milli>(clock_type::now() - start - d).count();
+    }
+    done.count_down();
+}
+
+co::task<> all(int timers, int rounds, clock_type::duration slack, std::vector<double>& late_ms) {
+    co::async_latch done{timers};
+    for (int i = 0; i < timers; ++i) {
+        co::executor::current()->spawn(sleeper(static_cast<unsigned>(i), rounds, slack, late_ms, done));
+    }
+    co_await done.wait();
+}
+
+int main(int argc, char** argv) {
+    int timers = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::printf("%d timers x %d sleeps of 50-150 ms, coarse clock resolution %.1f ms\n", timers, rounds,
+                std::chrono::duration<double, std::milli>(co::coarse_clock::resolution()).count());
+    std::printf("%-8s %9s %12s %9s %9s %9s\n", "slack", "wakeups", "per wakeup", "late p50", "late p99", "cpu ms");
+    for (auto slack: {0ms, 1ms, 4ms, 16ms, 64ms}) {
+        co::executor ex{1};
+        std::vector<double> late_ms(std::size_t(timers) * rounds);
+        auto before = ex.stats();
+        auto cpu = cpu_seconds();
+        ex.block_on(all(timers, rounds, slack, late_ms));
+        cpu = cpu_seconds() - cpu;
+        auto after = ex.stats();
+        std::sort(late_ms.begin(), late_ms.end());
+        auto wakeups = after.timer_wakeups - before.timer_wakeups;
+        auto fired = after.timers_fired - before.timers_fired;
+        std::printf("%-8lld %9llu %12.1f %9.2f %9.2f %9.0f\n", static_cast<long long>(slack.count()),
+                    static_cast<unsigned long long>(wakeups), double(fired) / double(wakeups ? wakeups : 1),
+                    late_ms[late_ms.size() / 2], late_ms[late_ms.size() * 99 / 100], cpu * 1e3);
+    }
+
+    co::timer_wheel wheel;
+    co::timer_node node;
+    node.fire = [](co::timer_node*) {};
+    for (auto slack: {0ms, 16ms}) {
+        constexpr int n = 1'000'000;
+        auto start = clock_type::now();
+        for (int i = 0; i < n; ++i) {
+            wheel.arm(&node, 10s, slack);
+            wheel.cancel(&node);
+        }
+        auto ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+        std::printf("arm + cancel, slack %lld ms: %.1f ns\n", static_cast<long long>(slack.count()), ns);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <source_location>
+#include <stop_token>
+#include <utility>
+
+#include "frame_registry.hpp"
+#include "stats.hpp"
+
+namespace co {
+    /// a generator whose body may `co_await`: the consumer pulls with
+    ///
+    ///     while (auto* v = co_await gen.next()) use(*v);
+    ///
+    /// `next()` transfers into the generator and `co_yield` transfers straight back, so an
+    /// element costs two symmetric transfers and nothing is queued. the pointer stays valid
+    /// until the next `next()`; nullptr means the body returned, and an exception escaping
+    /// the body is rethrown from `next()`
+    ///
+    /// the body runs wherever it was last resumed, so after a `co_await` inside it the
+    /// consumer continues on that thread; `stop` is inherited from the consumer like a task's
+    template<class T>
+    struct async_generator {
+        struct promise_t : detail::counted_frame, detail::tracked_frame {
+            const T* value = nullptr;
+            std::exception_ptr error;
+            std::coroutine_handle<> consumer = std::noop_coroutine();
+            std::stop_token stop;
+
+            promise_t(std::source_location loc = std::source_location::current()) : detail::tracked_frame(loc) {}
+
+            async_generator get_return_object() {
+                return async_generator{std::coroutine_handle<promise_t>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct yield_awaitable {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept {
+                    return h.promise().consumer;
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            yield_awaitable final_suspend() noexcept {
+                value = nullptr;
+                return {};
+            }
+
+            yield_awaitable yield_value(const T& v) noexcept {
+                value = std::addressof(v);
+                return {};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        /// trait
+        using promise_type = promise_t;
+
+        using handle_t = std::coroutine_handle<promise_type>;
+        handle_t handle;
+
+        explicit async_generator(handle_t h) : handle(h) {}
+
+        async_generator(async_generator&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+        async_generator& operator=(async_generator&& other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        // destroying a generator suspended at a `co_await` is the caller's bug, as for a task
+        ~async_generator() {
+            if (handle) handle.destroy();
+        }
+
+        struct next_awaitable {
+            handle_t h;
+
+            bool await_ready() noexcept { return h.done(); }
+
+            template<class P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> caller) noexcept {
+                if constexpr (requires { caller.promise().stop; }) {
+                    if (!h.promise().stop.stop_possible()) h.promise().stop = caller.promise().stop;
+                }
+                h.promise().consumer = caller;
+                return h;
+            }
+
+            const T* await_resume() {
+                auto& p = h.promise();
+                if (p.error) std::rethrow_exception(std::exchange(p.error, nullptr));
+                return h.done() ? nullptr : p.value;
+            }
+        };
+
+        next_awaitable next() noexcept { return {handle}; }
+    };
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <utility>
+
+#include "async_generator.hpp"
+#include "views.hpp"
+
+namespace co {
+    namespace detail {
+        using crc32c_fn = std::uint32_t (*)(std::uint32_t, const unsigned char*, std::size_t) noexcept;
+
+        // slicing-by-8 tables for the reflected Castagnoli polynomial: `[k][b]` is the crc
+        // of byte `b` followed by `k` zero bytes
+        constexpr std::array<std::array<std::uint32_t, 256>, 8> make_crc32c_tables() {
+            std::array<std::array<std::uint32_t, 256>, 8> t{};
+            for (std::uint32_t b = 0; b < 256; ++b) {
+                std::uint32_t c = b;
+                for (int i = 0; i < 8; ++i) c = c & 1 ? (c >> 1) ^ 0x82f63b78u : c >> 1;
+                t[0][b] = c;
+            }
+            for (std::size_t k = 1; k < 8; ++k) {
+                for (std::size_t b = 0; b < 256; ++b) t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xff];
+            }
+            return t;
+        }
+
+        inline constexpr auto crc32c_tables = make_crc32c_tables();
+
+        // 8 bytes per step through 8 table lookups; little-endian only, like the rest of
+        // the runtime
+        inline std::uint32_t crc32c_table(std::uint32_t crc, const unsigned char* p, std::size_t n) noexcept {
+            auto& t = crc32c_tables;
+            for (; n >= 8; p += 8, n -= 8) {
+                std::uint64_t w;
+                std::memcpy(&w, p, 8);
+                w ^= crc;
+                crc = t[7][w & 0xff] ^ t[6][(w >> 8) & 0xff] ^ t[5][(w >> 16) & 0xff] ^ t[4][(w >> 24) & 0xff]
+                      ^ t[3][(w >> 32) & 0xff] ^ t[2][(w >> 40) & 0xff] ^ t[1][(w >> 48) & 0xff] ^ t[0][w >> 56];
+            }
+            for (; n; ++p, --n) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+            return crc;
+        }
+
+        // gf(2) 32x32 matrices, for the operator that appends zero bytes to a crc
+        constexpr std::uint32_t gf2_times(const std::array<std::uint32_t, 32>& m, std::uint32_t v) {
+            std::uint32_t sum = 0;
+            for (std::size_t i = 0; v; v >>= 1, ++i) {
+                if (v & 1) sum ^= m[i];
+            }
+            return sum;
+        }
+
+        constexpr std::array<std::uint32_t, 32> gf2_square(const std::array<std::uint32_t, 32>& m) {
+            std::array<std::uint32_t, 32> sq{};
+            for (std::size_t i = 0; i < 32; ++i) sq[i] = gf2_times(m, m[i]);
+            return sq;
+        }
+
+        // `[k][b]`: byte `b` at position `k` of a crc register, moved past `len` zero bytes;
+        // joins crcs of adjacent runs: crc(a + b) = shift(crc(a)) ^ crc(b)
+        constexpr std::array<std::array<std::uint32_t, 256>, 4> make_crc32c_shift(std::size_t len) {
+            std::array<std::uint32_t, 32> op{};  // one zero bit
+            op[0] = 0x82f63b78u;
+            for (std::size_t i = 1; i < 32; ++i) op[i] = 1u << (i - 1);
+            for (int i = 0; i < 3; ++i) op = gf2_square(op);  // one zero byte
+            std::array<std::uint32_t, 32> total{};
+            for (std::size_t i = 0; i < 32; ++i) total[i] = 1u << i;
+            for (; len; len >>= 1, op = gf2_square(op)) {
+                if (len & 1) {
+                    std::array<std::uint32_t, 32> next{};
+                    for (std::size_t i = 0; i < 32; ++i) next[i] = gf2_times(op, total[i]);
+                    total = next;
+                }
+            }
+            std::array<std::array<std::uint32_t, 256>, 4> t{};
+            for (std::uint32_t b = 0; b < 256; ++b) {
+                for (std::size_t k = 0; k < 4; ++k) t[k][b] = gf2_times(total, b << (8 * k));
+            }
+            return t;
+        }
+
+#if defined(__x86_64__)
+        inline constexpr std::size_t crc32c_stride = 4096;
+        inline constexpr auto crc32c_shift_table = make_crc32c_shift(crc32c_stride);
+
+        inline std::uint32_t crc32c_shift(std::uint32_t crc) noexcept {
+            auto& t = crc32c_shift_table;
+            return t[0][crc & 0xff] ^ t[1][(crc >> 8) & 0xff] ^ t[2][(crc >> 16) & 0xff] ^ t[3][crc >> 24];
+        }
+
+        // the SSE4.2 `crc32` instruction takes 3 cycles but can start every cycle, so
+        // three runs of `crc32c_stride` bytes go side by side and are joined afterwards
+        __attribute__((target("sse4.2"))) inline std::uint32_t crc32c_sse42(std::uint32_t crc, const unsigned char* p,
+                                                                             std::size_t n) noexcept {
+            std::uint64_t c0 = crc;
+            constexpr auto stride = crc32c_stride;
+            for (; n >= 3 * stride; p += 3 * stride, n -= 3 * stride) {
+                std::uint64_t c1 = 0, c2 = 0;
+                for (std::size_t i = 0; i < stride; i += 8) {
+                    std::uint64_t w0, w1, w2;
+                    std::memcpy(&w0, p + i, 8);
+                    std::memcpy(&w1, p + stride + i, 8);
+                    std::memcpy(&w2, p + 2 * stride + i, 8);
+                    c0 = __builtin_ia32_crc32di(c0, w0);
+                    c1 = __builtin_ia32_crc32di(c1, w1);
+                    c2 = __builtin_ia32_crc32di(c2, w2);
+                }
+                c0 = crc32c_shift(static_cast<std::uint32_t>(c0)) ^ c1;
+                c0 = crc32c_shift(static_cast<std::uint32_t>(c0)) ^ c2;
+            }
+            for (; n >= 8; p += 8, n -= 8) {
+                std::uint64_t w;
+                std::memcpy(&w, p, 8);
+                c0 = __builtin_ia32_crc32di(c0, w);
+            }
+            auto c32 = static_cast<std::uint32_t>(c0);
+            for (; n; ++p, --n) c32 = __builtin_ia32_crc32qi(c32, *p);
+            return c32;
+        }
+#endif
+
+        // chosen once at startup from what the cpu supports
+        inline crc32c_fn pick_crc32c() noexcept {
+#if defined(__x86_64__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse4.2")) return crc32c_sse42;
+#endif
+            return crc32c_table;
+        }
+
+        inline const crc32c_fn crc32c_kernel = pick_crc32c();
+    }
+
+    /// CRC-32C (Castagnoli, as in iSCSI, ext4 and RocksDB) over everything passed to
+    /// `update`; runs on the SSE4.2 instruction where there is one, else on tables
+    struct crc32c {
+        std::uint32_t state = 0xffffffffu;
+
+        void update(std::span<const std::byte> data) noexcept {
+            state = detail::crc32c_kernel(state, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+        }
+
+        std::uint32_t value() const noexcept { return ~state; }
+    };
+
+    /// XXH64, fed in pieces: the same value as one XXH64 over everything passed to
+    /// `update`. whole 32 byte stripes are hashed in place; only the bytes that do not
+    /// fill one are copied, to wait for the next piece
+    struct xxhash64 {
+        explicit xxhash64(std::uint64_t seed = 0) noexcept
+                : seed(seed), acc{seed + p1 + p2, seed + p2, seed, seed - p1} {}
+
+        void update(std::span<const std::byte> data) noexcept {
+            auto* p = reinterpret_cast<const unsigned char*>(data.data());
+            auto n = data.size();
+            total += n;
+            if (buffered) {
+                auto take = std::min(n, sizeof(buf) - buffered);
+                std::memcpy(buf + buffered, p, take);
+                buffered += take;
+                p += take;
+                n -= take;
+                if (buffered < sizeof(buf)) return;
+                stripe(buf);
+                buffered = 0;
+            }
+            for (; n >= 32; p += 32, n -= 32) stripe(p);
+            std::memcpy(buf, p, n);
+            buffered = n;
+        }
+
+        std::uint64_t value() const noexcept {
+            std::uint64_t h;
+            if (total >= 32) {
+                h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+                for (auto v: acc) h = (h ^ round(0, v)) * p1 + p4;
+            } else {
+                h = seed + p5;
+            }
+            h += total;
+            const unsigned char* p = buf;
+            auto n = buffered;
+            for (; n >= 8; p += 8, n -= 8) h = rotl(h ^ round(0, load64(p)), 27) * p1 + p4;
+            if (n >= 4) {
+                h = rotl(h ^ (load32(p) * p1), 23) * p2 + p3;
+                p += 4;
+                n -= 4;
+            }
+            for (; n; ++p, --n) h = rotl(h ^ (*p * p5), 11) * p1;
+            h ^= h >> 33;
+            h *= p2;
+            h ^= h >> 29;
+            h *= p3;
+            return h ^ (h >> 32);
+        }
+
+    private:
+        static constexpr std::uint64_t p1 = 0x9e3779b185ebca87ull;
+        static constexpr std::uint64_t p2 = 0xc2b2ae3d27d4eb4full;
+        static constexpr std::uint64_t p3 = 0x165667b19e3779f9ull;
+        static constexpr std::uint64_t p4 = 0x85ebca77c2b2ae63ull;
+        static constexpr std::uint64_t p5 = 0x27d4eb2f165667c5ull;
+
+        std::uint64_t seed;
+        std::uint64_t acc[4];
+        std::uint64_t total = 0;
+        unsigned char buf[32];
+        std::size_t buffered = 0;
+
+        static std::uint64_t rotl(std::uint64_t x, int r) noexcept { return (x << r) | (x >> (64 - r)); }
+
+        static std::uint64_t round(std::uint64_t a, std::uint64_t input) noexcept { return rotl(a + input * p2, 31) * p1; }
+
+        static std::uint64_t load64(const unsigned char* p) noexcept {
+            std::uint64_t v;
+            std::memcpy(&v, p, 8);
+            return v;
+        }
+
+        static std::uint64_t load32(const unsigned char* p) noexcept {
+            std::uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        // four independent lanes, so the multiplies overlap
+        void stripe(const unsigned char* p) noexcept {
+            for (int i = 0; i < 4; ++i) acc[i] = round(acc[i], load64(p + 8 * i));
+        }
+    };
+
+    /// passes a stream of chunks through unchanged and feeds each one to `h` on the way
+    /// (`crc32c`, `xxhash64`, or anything with `update(std::span<const std::byte>)`)
+    /// while it is still in cache, instead of hashing everything again afterwards:
+    ///
+    ///     co::crc32c crc;
+    ///     auto blocks = co::checksummed(read_blocks(fd), crc);
+    ///     while (auto* b = co_await blocks.next()) co_await write(*b);
+    ///     footer.crc = crc.value();
+    ///
+    /// for a `co::generator` of chunks the same stage is `| views::checksum(crc)`
+    template<class T, class H>
+    async_generator<std::span<const T>> checksummed(async_generator<std::span<const T>> source, H& h) {
+        while (auto* chunk = co_await source.next()) {
+            h.update(std::as_bytes(*chunk));
+            co_yield *chunk;
+        }
+    }
+}
+
+namespace co::views {
+    /// each chunk (anything with `data()` and `size()`) is hashed the moment the source
+    /// produces it, before the consumer sees it; no copy, one frame as before
+    template<class R, class H>
+    struct checksum_view {
+        R base;
+        H* h;
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = detail::value_t<R>;
+
+            checksum_view* v;
+            detail::iterator_t<R> it;
+
+            void feed() {
+                if (it == v->base.end()) return;
+                auto&& c = *it;
+                v->h->update(std::as_bytes(std::span{c.data(), c.size()}));
+            }
+
+            decltype(auto) operator*() const { return *it; }
+
+            iterator& operator++() {
+                ++it;
+                feed();
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& i, std::default_sentinel_t) { return i.it == i.v->base.end(); }
+        };
+
+        iterator begin() {
+            iterator i{this, base.begin()};
+            i.feed();
+            return i;
+        }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    template<class H>
+    auto checksum(H& h) {
+        return detail::closure{[h = &h]<class R>(R&& r) { return checksum_view<R, H>{std::forward<R>(r), h}; }};
+    }
+}
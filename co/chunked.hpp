@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "generator.hpp"
+#include "views.hpp"
+
+namespace co {
+    /// a generator that resumes once per chunk rather than once per element; the consumer
+    /// gets contiguous memory it can run a vectorised loop over, or `| views::flatten` to
+    /// go back to one element at a time
+    template<class T>
+    using chunked_generator = generator<std::span<const T>>;
+
+    /// producer side of a `chunked_generator`:
+    ///
+    ///     chunk_buffer<int> out{256};
+    ///     for (...) {
+    ///         out.push(v);
+    ///         if (out.full()) co_yield out.take();
+    ///     }
+    ///     if (!out.empty()) co_yield out.take();
+    ///
+    /// the span from `take` stays valid until the producer is resumed and pushes again
+    template<class T>
+    struct chunk_buffer {
+        explicit chunk_buffer(std::size_t capacity) : capacity(capacity ? capacity : 1) { items.reserve(this->capacity); }
+
+        void push(const T& v) {
+            if (taken) clear();
+            items.push_back(v);
+        }
+
+        // room for `n` more, written in place: for producers that fill a run at once
+        std::span<T> append(std::size_t n) {
+            if (taken) clear();
+            auto at = items.size();
+            items.resize(at + n);
+            return std::span<T>{items}.subspan(at);
+        }
+
+        bool full() const noexcept { return !taken && items.size() >= capacity; }
+
+        bool empty() const noexcept { return taken || items.empty(); }
+
+        std::span<const T> take() noexcept {
+            taken = true;
+            return items;
+        }
+
+    private:
+        std::size_t capacity;
+        std::vector<T> items;
+        bool taken = false;
+
+        void clear() {
+            items.clear();
+            taken = false;
+        }
+    };
+}
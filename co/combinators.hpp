@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <stop_token>
+#include <type_traits>
+#include <vector>
+
+#include "executor.hpp"
+
+namespace co {
+    struct timed_out : operation_cancelled {
+        const char* what() const noexcept override { return "co::timed_out"; }
+    };
+
+    /// runs `t` with a deadline: when it passes, `t`'s stop token is triggered so whatever
+    /// it is suspended on gets cancelled, and `timed_out` is thrown once `t` has unwound
+    /// `t` is always awaited to the end, never left running detached
+    template<class T>
+    task<T> with_timeout(task<T> t, timer_wheel::clock::duration d) {
+        struct deadline_t : timer_node {
+            enum { armed, joining, done };
+
+            std::stop_source source;
+            executor* ex = executor::current();
+            work_item joiner;
+            std::atomic<int> state{armed};
+        } deadline;
+        deadline.fire = [](timer_node* n) {
+            auto* self = static_cast<deadline_t*>(n);
+            self->source.request_stop();
+            // last touch of our frame, unless we're the one to resume it
+            if (self->state.exchange(deadline_t::done, std::memory_order_acq_rel) == deadline_t::joining) {
+                self->ex->schedule(&self->joiner);
+            }
+        };
+        // waits for `fire` to finish on the driver thread without holding up the worker
+        struct join_t {
+            deadline_t& d;
+
+            bool await_ready() noexcept { return d.state.load(std::memory_order_acquire) == deadline_t::done; }
+
+            bool await_suspend(std::coroutine_handle<> h) noexcept {
+                d.joiner.handle = h;
+                return d.state.exchange(deadline_t::joining, std::memory_order_acq_rel) != deadline_t::done;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        // cancelling us cancels `t` too
+        auto outer = co_await get_stop_token();
+        std::stop_callback forward{outer, [&deadline] { deadline.source.request_stop(); }};
+        t.handle.promise().stop = deadline.source.get_token();
+
+        auto& wheel = deadline.ex->timers();
+        wheel.arm(&deadline, d);
+        detail::task_result<T> out;
+        bool cancelled = false;
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(t);
+                out.return_void();
+            } else {
+                out.return_value(co_await std::move(t));
+            }
+        } catch (const operation_cancelled&) {
+            cancelled = true;
+        } catch (...) {
+            out.unhandled_exception();
+        }
+
+        bool fired = !wheel.cancel(&deadline);
+        // the driver thread may still be inside `fire`
+        if (fired) co_await join_t{deadline};
+        if (cancelled) {
+            if (fired && !outer.stop_requested()) throw timed_out{};
+            throw operation_cancelled{};
+        }
+        co_return out.get();
+    }
+
+    struct retry_policy {
+        int max_attempts = 3;
+        std::chrono::milliseconds initial_backoff{10};
+        std::chrono::milliseconds max_backoff{1000};
+        double multiplier = 2.0;
+    };
+
+    namespace detail {
+        // "full jitter": uniform in [0, backoff], so retrying callers spread out
+        inline std::chrono::milliseconds jittered(std::chrono::milliseconds backoff) {
+            thread_local std::minstd_rand rng{std::random_device{}()};
+            return std::chrono::milliseconds{
+                    std::uniform_int_distribution<std::chrono::milliseconds::rep>{0, backoff.count()}(rng)};
+        }
+    }
+
+    /// `co_await co::retry(policy, [&] { return fetch(key); })`
+    /// calls `factory` for a fresh task per attempt and sleeps a jittered, exponentially
+    /// growing backoff between failures. the last failure is rethrown, and nothing is
+    /// retried once the retry itself is cancelled. a `timed_out` attempt (from
+    /// `with_timeout` inside the factory) is an ordinary failure
+    template<class Factory, class Task = std::invoke_result_t<Factory&>>
+    Task retry(retry_policy policy, Factory factory) {
+        auto token = co_await get_stop_token();
+        auto backoff = policy.initial_backoff;
+        for (int attempt = 1;; ++attempt) {
+            try {
+                co_return co_await factory();
+            } catch (...) {
+                if (attempt >= policy.max_attempts || token.stop_requested()) throw;
+            }
+            co_await sleep_for(detail::jittered(backoff));
+            backoff = std::min(std::chrono::duration_cast<std::chrono::milliseconds>(backoff * policy.multiplier),
+                               policy.max_backoff);
+        }
+    }
+
+    namespace detail {
+        struct when_all_state {
+            std::atomic<std::size_t> remaining;
+            std::coroutine_handle<> parent;
+        };
+
+        // wraps one child of `when_all`: the last one to finish resumes the parent
+        struct when_all_child {
+            struct promise_t : counted_frame {
+                when_all_state* state = nullptr;
+                work_item item;
+
+                when_all_child get_return_object() {
+                    return when_all_child{std::coroutine_handle<promise_t>::from_promise(*this)};
+                }
+
+                std::suspend_always initial_suspend() noexcept { return {}; }
+
+                struct final_awaitable {
+                    bool await_ready() noexcept { return false; }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept {
+                        auto* state = h.promise().state;
+                        if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) return state->parent;
+                        return std::noop_coroutine();
+                    }
+
+                    void await_resume() noexcept {}
+                };
+
+                final_awaitable final_suspend() noexcept { return {}; }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+
+            using promise_type = promise_t;
+            std::coroutine_handle<promise_t> handle;
+
+            explicit when_all_child(std::coroutine_handle<promise_t> h) : handle(h) {}
+
+            when_all_child(when_all_child&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+            ~when_all_child() {
+                if (handle) handle.destroy();
+            }
+        };
+
+        template<class T>
+        when_all_child run_child(task<T> t, task_result<T>& out) {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await std::move(t);
+                    out.return_void();
+                } else {
+                    out.return_value(co_await std::move(t));
+                }
+            } catch (...) {
+                out.unhandled_exception();
+            }
+        }
+
+        // puts every child on the executor in one go; the parent resumes after the last
+        struct when_all_awaitable {
+            when_all_state& state;
+            std::vector<when_all_child>& children;
+
+            bool await_ready() noexcept { return children.empty(); }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                state.parent = h;
+                work_queue q;
+                for (auto& c: children) {
+                    c.handle.promise().state = &state;
+                    c.handle.promise().item.handle = c.handle;
+                    q.push_back(&c.handle.promise().item);
+                }
+                executor::current()->schedule(q);
+                // the extra count held by the parent: whoever drops it last resumes it
+                return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        template<class T>
+        using when_all_result_t = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+    }
+
+    /// runs every task concurrently on the current executor and waits for all of them
+    /// results come back in input order; the first exception (in input order) is rethrown
+    /// once everything has finished. children inherit the caller's stop token
+    template<class T>
+    task<detail::when_all_result_t<T>> when_all(std::vector<task<T>> tasks) {
+        auto token = co_await get_stop_token();
+        std::vector<detail::task_result<T>> results(tasks.size());
+        std::vector<detail::when_all_child> children;
+        children.reserve(tasks.size());
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            tasks[i].handle.promise().stop = token;
+            children.push_back(detail::run_child(std::move(tasks[i]), results[i]));
+        }
+        detail::when_all_state state{children.size() + 1, {}};
+        co_await detail::when_all_awaitable{state, children};
+
+        if constexpr (std::is_void_v<T>) {
+            for (auto& r: results) r.get();
+        } else {
+            std::vector<T> values;
+            values.reserve(results.size());
+            for (auto& r: results) values.push_back(r.get());
+            co_return values;
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "generator.hpp"
+
+namespace co {
+    struct csv_options {
+        char delimiter = ',';  // '\t' for TSV
+        char quote = '"';  // 0 when fields are never quoted
+    };
+
+    namespace detail {
+        // one bit per byte of a 64 byte block
+        struct csv_masks {
+            std::uint64_t delimiter;
+            std::uint64_t quote;
+            std::uint64_t newline;
+        };
+
+        using csv_scan_fn = csv_masks (*)(const char*, char, char) noexcept;
+
+        inline csv_masks csv_scan_scalar(const char* p, char delimiter, char quote) noexcept {
+            csv_masks m{};
+            for (int i = 0; i < 64; ++i) {
+                m.delimiter |= std::uint64_t(p[i] == delimiter) << i;
+                m.quote |= std::uint64_t(p[i] == quote) << i;
+                m.newline |= std::uint64_t(p[i] == '\n') << i;
+            }
+            return m;
+        }
+
+#if defined(__x86_64__)
+        // SSE2 is part of x86-64, so this one needs no check
+        inline csv_masks csv_scan_sse2(const char* p, char delimiter, char quote) noexcept {
+            using v16 = char __attribute__((vector_size(16)));
+            csv_masks m{};
+            for (int i = 0; i < 4; ++i) {
+                v16 v;
+                std::memcpy(&v, p + 16 * i, 16);
+                auto bits = [&](char c) {
+                    return std::uint64_t(std::uint16_t(__builtin_ia32_pmovmskb128(v16(v == c)))) << (16 * i);
+                };
+                m.delimiter |= bits(delimiter);
+                m.quote |= bits(quote);
+                m.newline |= bits('\n');
+            }
+            return m;
+        }
+
+        __attribute__((target("avx2"))) inline csv_masks csv_scan_avx2(const char* p, char delimiter, char quote) noexcept {
+            using v32 = char __attribute__((vector_size(32)));
+            csv_masks m{};
+            for (int i = 0; i < 2; ++i) {
+                v32 v;
+                std::memcpy(&v, p + 32 * i, 32);
+                auto bits = [&](char c) {
+                    return std::uint64_t(std::uint32_t(__builtin_ia32_pmovmskb256(v32(v == c)))) << (32 * i);
+                };
+                m.delimiter |= bits(delimiter);
+                m.quote |= bits(quote);
+                m.newline |= bits('\n');
+            }
+            return m;
+        }
+#endif
+
+        inline csv_scan_fn pick_csv_scan() noexcept {
+#if defined(__x86_64__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return csv_scan_avx2;
+            return csv_scan_sse2;
+#else
+            return csv_scan_scalar;
+#endif
+        }
+
+        inline const csv_scan_fn csv_scan_kernel = pick_csv_scan();
+
+        // bit i is the parity of the quotes at or before i: set inside a quoted field
+        constexpr std::uint64_t prefix_xor(std::uint64_t x) noexcept {
+            for (int s = 1; s < 64; s <<= 1) x ^= x << s;
+            return x;
+        }
+
+        inline std::string_view csv_field(const char* from, const char* to, char quote, bool last) noexcept {
+            if (last && from != to && to[-1] == '\r') --to;
+            if (quote && to - from >= 2 && *from == quote && to[-1] == quote) {
+                ++from;
+                --to;
+            }
+            return {from, static_cast<std::size_t>(to - from)};
+        }
+
+        // the loop over field ends, in a plain function: inside the coroutine every local
+        // would live in the frame and be reloaded from memory
+        struct csv_scanner {
+            csv_scanner(std::string_view text, csv_options opts) : text(text), opts(opts) {}
+
+            // fills `fields` with the next record; false at the end of the text
+            bool next(std::vector<std::string_view>& fields) {
+                fields.clear();
+                const char* data = text.data();
+                for (;;) {
+                    while (ends) {
+                        auto bit = std::countr_zero(ends);
+                        ends &= ends - 1;
+                        auto at = base + static_cast<std::size_t>(bit);
+                        bool eol = (newlines >> bit) & 1;
+                        fields.push_back(csv_field(data + start, data + at, opts.quote, eol));
+                        start = at + 1;
+                        if (!eol) continue;
+                        if (fields.size() > 1 || !fields.front().empty()) return true;
+                        fields.clear();
+                    }
+                    if (next_block < text.size()) {
+                        load();
+                        continue;
+                    }
+                    // no newline after the last record
+                    if (start >= text.size() && fields.empty()) return false;
+                    fields.push_back(csv_field(data + start, data + text.size(), opts.quote, true));
+                    start = text.size();
+                    return true;
+                }
+            }
+
+        private:
+            std::string_view text;
+            csv_options opts;
+            std::size_t next_block = 0;
+            std::size_t base = 0;  // of the block `ends` came from
+            std::uint64_t ends = 0;  // field ends not handed out yet
+            std::uint64_t newlines = 0;
+            std::uint64_t in_quotes = 0;  // all ones while a quoted field runs on into the next block
+            std::size_t start = 0;  // of the current field
+
+            void load() {
+                base = next_block;
+                next_block += 64;
+                const char* p = text.data() + base;
+                auto n = std::min<std::size_t>(64, text.size() - base);
+                char tail[64];
+                if (n < 64) {
+                    std::memcpy(tail, p, n);
+                    std::memset(tail + n, 0, 64 - n);
+                    p = tail;
+                }
+                auto m = csv_scan_kernel(p, opts.delimiter, opts.quote);
+                if (!opts.quote) m.quote = 0;
+                auto quoted = prefix_xor(m.quote) ^ in_quotes;
+                in_quotes = quoted >> 63 ? ~std::uint64_t(0) : 0;
+                ends = (m.delimiter | m.newline) & ~quoted;
+                if (n < 64) ends &= (std::uint64_t(1) << n) - 1;
+                newlines = m.newline;
+            }
+        };
+    }
+
+    /// the records of a CSV or TSV text, e.g. a `mapped_file`, one `co_yield` per record:
+    ///
+    ///     co::mapped_file in{"events.csv"};
+    ///     for (auto fields: co::csv_records(in.text())) total += parse(fields[3]);
+    ///
+    /// fields are views into `text`, so nothing is copied, and the span is a vector that
+    /// lives in the frame and is refilled for every record: after the widest record there
+    /// are no allocations. the span stays valid until the next record is asked for
+    ///
+    /// 64 bytes are classified at a time: SIMD compares (AVX2 if the cpu has it, else
+    /// SSE2) give a bitmask each for delimiters, quotes and newlines, a prefix xor over the
+    /// quotes masks out what sits inside quoted fields, and the remaining bits are the
+    /// field ends. the surrounding quotes are stripped, but an escaped `""` inside stays
+    /// as it is, since unescaping would need a copy. a `\r` before the `\n` is dropped
+    /// and blank lines are skipped
+    inline generator<std::span<const std::string_view>> csv_records(std::string_view text, csv_options opts = {}) {
+        std::vector<std::string_view> fields;
+        detail::csv_scanner scan{text, opts};
+        while (scan.next(fields)) co_yield std::span<const std::string_view>{fields};
+    }
+}
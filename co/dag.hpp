@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "executor.hpp"
+#include "sync.hpp"
+#include "task.hpp"
+
+namespace co {
+    namespace detail {
+        struct dag_node {
+            task<> (*body)(dag_node*) = nullptr;
+            std::vector<dag_node*> successors;
+            std::size_t in_degree = 0;
+            std::atomic<std::size_t> pending{0};  // inputs not finished yet in this run
+
+            virtual ~dag_node() = default;
+        };
+
+        template<class T>
+        struct dag_result : dag_node {
+            std::optional<T> value;
+            std::atomic<std::size_t> readers{0};  // successors (and `dag::keep`) that have not taken `value` yet
+
+            // the last reader gets the value moved, the others a copy: every reader
+            // decrements only after its copy, so a reader that still sees 1 is alone
+            T take() {
+                if (readers.load(std::memory_order_acquire) == 1) {
+                    readers.store(0, std::memory_order_relaxed);
+                    // emptied, so `dag::result` can tell it is gone
+                    T moved = std::move(*value);
+                    value.reset();
+                    return moved;
+                }
+                if constexpr (std::copy_constructible<T>) {
+                    T copy = *value;
+                    readers.fetch_sub(1, std::memory_order_release);
+                    return copy;
+                } else {
+                    std::terminate();  // `dag::add` refuses a second reader
+                }
+            }
+        };
+
+        // a node that returns nothing only orders its successors
+        template<>
+        struct dag_result<void> : dag_node {};
+
+        template<class T>
+        using dag_arg_t = std::conditional_t<std::is_void_v<T>, std::tuple<>, std::tuple<T>>;
+
+        template<class T>
+        dag_arg_t<T> dag_arg(dag_result<T>* in) {
+            if constexpr (std::is_void_v<T>) {
+                return {};
+            } else {
+                return dag_arg_t<T>{in->take()};
+            }
+        }
+
+        template<class Task>
+        struct dag_task_value;
+
+        template<class T>
+        struct dag_task_value<task<T>> {
+            using type = T;
+        };
+
+        template<class F, class... In>
+        using dag_value_t = typename dag_task_value<decltype(std::apply(
+                std::declval<F&>(), std::declval<decltype(std::tuple_cat(std::declval<dag_arg_t<In>>()...))>()))>::type;
+
+        template<class R, class F, class... In>
+        struct dag_task_node : dag_result<R> {
+            F f;
+            std::tuple<dag_result<In>*...> inputs;
+
+            dag_task_node(F f, dag_result<In>*... in) : f(std::move(f)), inputs(in...) { this->body = run; }
+
+            // `f` lives in the node, so a coroutine lambda's captures outlive its frame
+            static task<> run(dag_node* n) {
+                auto* self = static_cast<dag_task_node*>(n);
+                auto args = std::apply([](auto*... in) { return std::tuple_cat(dag_arg(in)...); }, self->inputs);
+                if constexpr (std::is_void_v<R>) {
+                    co_await std::apply(self->f, std::move(args));
+                } else {
+                    self->value.emplace(co_await std::apply(self->f, std::move(args)));
+                }
+            }
+        };
+    }
+
+    /// a graph of coroutine tasks, each started as soon as the nodes it depends on are done:
+    ///
+    ///     co::dag g;
+    ///     auto src = g.add([]() -> co::task<std::string> { co_return co_await load(); });
+    ///     auto ast = g.add([](std::string s) -> co::task<tree> { co_return parse(s); }, src);
+    ///     auto sym = g.add([](std::string s) -> co::task<table> { co_return scan(s); }, src);
+    ///     g.add([](tree t, table s) -> co::task<> { co_await emit(t, s); }, ast, sym);
+    ///     co_await g.run();
+    ///
+    /// a node's function gets the results of its inputs as arguments, in order. a value
+    /// is moved into the last node to take it and copied for the others; inputs that
+    /// return `task<>` pass nothing and only order the two nodes. `result(node)` reads
+    /// what a node returned after the run. a value moved into a successor is gone, and
+    /// `result` throws for it: `keep(node)` before the run counts the caller as one more
+    /// reader, so every successor gets a copy and the value stays
+    ///
+    /// there is no scheduler and no lock: every node counts its unfinished inputs in an
+    /// atomic, and whichever input finishes last starts it. one ready successor runs
+    /// on in the same coroutine, and the others are spawned. after an exception no
+    /// further nodes start, and `run` rethrows it once the running ones are done
+    struct dag {
+        template<class T>
+        struct node {
+            detail::dag_result<T>* n;
+        };
+
+        dag() = default;
+
+        dag(const dag&) = delete;
+
+        dag& operator=(const dag&) = delete;
+
+        template<class F, class... In>
+        node<detail::dag_value_t<F, In...>> add(F f, node<In>... inputs) {
+            using R = detail::dag_value_t<F, In...>;
+            (check_reader(inputs), ...);
+            auto owned = std::make_unique<detail::dag_task_node<R, F, In...>>(std::move(f), inputs.n...);
+            auto* n = owned.get();
+            n->in_degree = sizeof...(In);
+            (inputs.n->successors.push_back(n), ...);
+            nodes.push_back(std::move(owned));
+            return {n};
+        }
+
+        /// one more reader of `h`, outside the graph: its value is left for `result`
+        template<class T>
+        void keep(node<T> h) {
+            check_reader(h);
+        }
+
+        template<class T>
+        T& result(node<T> h) {
+            if (!h.n->value) throw std::logic_error("co::dag::result: no value, not run or moved into a successor");
+            return *h.n->value;
+        }
+
+        std::size_t size() const noexcept { return nodes.size(); }
+
+        /// runs the graph on the current executor; only once, as results are moved along
+        task<> run() {
+            ex = executor::current();
+            if (!ex) throw std::logic_error("co::dag::run must be awaited on an executor worker");
+            if (std::exchange(ran, true)) throw std::logic_error("co::dag::run called twice");
+            async_latch finished{static_cast<std::ptrdiff_t>(nodes.size())};
+            done = &finished;
+            for (auto& n: nodes) n->pending.store(n->in_degree, std::memory_order_relaxed);
+            for (auto& n: nodes) {
+                if (n->in_degree == 0) ex->spawn(drive(*this, n.get()));
+            }
+            co_await finished.wait();
+            if (failed.load(std::memory_order_acquire)) std::rethrow_exception(error);
+        }
+
+    private:
+        std::vector<std::unique_ptr<detail::dag_node>> nodes;
+        executor* ex = nullptr;
+        async_latch* done = nullptr;
+        bool ran = false;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+
+        template<class T>
+        void check_reader(node<T> in) {
+            if constexpr (!std::is_void_v<T>) {
+                auto readers = in.n->readers.load(std::memory_order_relaxed) + 1;
+                if constexpr (!std::copy_constructible<T>) {
+                    if (readers > 1) throw std::logic_error("co::dag: a move-only result can feed only one node");
+                }
+                in.n->readers.store(readers, std::memory_order_relaxed);
+            }
+        }
+
+        // runs `n`, then one successor it made ready, and so on down a chain
+        static task<> drive(dag& g, detail::dag_node* n) {
+            while (n) {
+                if (!g.failed.load(std::memory_order_acquire)) {
+                    try {
+                        co_await n->body(n);
+                    } catch (...) {
+                        if (!g.failed.exchange(true, std::memory_order_acq_rel)) g.error = std::current_exception();
+                    }
+                }
+                detail::dag_node* next = nullptr;
+                for (auto* s: n->successors) {
+                    if (s->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+                    if (next) {
+                        g.ex->spawn(drive(g, s));
+                    } else {
+                        next = s;
+                    }
+                }
+                // with no `next`, this may resume `run` and end the graph's life
+                g.done->count_down();
+                n = next;
+            }
+        }
+    };
+}
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "intrusive.hpp"
+#include "stats.hpp"
+#include "task.hpp"
+#include "timer.hpp"
+#include "topology.hpp"
+
+namespace co {
+    /// a runnable coroutine; lives inside whatever awaitable suspended it, so the ready
+    /// queues never allocate and a waiter list can be moved onto them wholesale
+    struct work_item {
+        work_item* next = nullptr;
+        std::coroutine_handle<> handle;
+    };
+
+    using work_queue = intrusive_queue<work_item>;
+
+    struct executor;
+
+    /// what an idle worker does before it sleeps: `spin_rounds` polls of the run queues,
+    /// with `pause` backoff doubling from 1 up to `max_pause` between them, then a futex
+    /// wait. `spin_rounds = 0` parks straight away and burns no CPU while idle
+    struct idle_policy {
+        unsigned spin_rounds = 12;
+        unsigned max_pause = 64;
+    };
+
+    namespace detail {
+        inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+
+        inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+        }
+
+        inline void futex_wake(std::atomic<std::uint32_t>& word, int n) noexcept {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+        }
+
+        inline thread_local executor* current_executor = nullptr;
+        inline thread_local std::size_t current_worker = 0;
+        inline thread_local std::size_t inline_depth = 0;
+
+        // fire-and-forget frame: destroys itself at final_suspend
+        struct detached_t {
+            struct promise_t : counted_frame {
+                work_item item;
+
+                detached_t get_return_object() {
+                    return {std::coroutine_handle<promise_t>::from_promise(*this)};
+                }
+
+                std::suspend_always initial_suspend() noexcept { return {}; }
+
+                std::suspend_never final_suspend() noexcept { return {}; }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+
+            using promise_type = promise_t;
+            std::coroutine_handle<promise_t> handle;
+        };
+
+        inline detached_t run_detached(task<> t) {
+            co_await std::move(t);
+        }
+
+        template<class T>
+        task<> run_and_signal(task<T> t, task_result<T>& out, std::binary_semaphore& done) {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await std::move(t);
+                    out.return_void();
+                } else {
+                    out.return_value(co_await std::move(t));
+                }
+            } catch (...) {
+                out.unhandled_exception();
+            }
+            done.release();
+        }
+    }
+
+    /// work-stealing thread pool
+    /// each worker owns a queue; `schedule` from a worker pushes locally, from anywhere else
+    /// into the global queue. an idle worker drains global, then steals, then spins and
+    /// parks as `idle_policy` says
+    ///
+    /// with `placement::pin` every worker is bound to one cpu for its lifetime, and steals
+    /// from workers sharing its core or L3 before going further afield
+    struct executor {
+        explicit executor(std::size_t n_workers = std::thread::hardware_concurrency(), idle_policy idle = {},
+                          placement where = {})
+                : workers(n_workers ? n_workers : 1), policy(idle) {
+            if (where.pin) placed = cpu_topology::read().plan(where, workers.size());
+            for (std::size_t i = 0; i < workers.size(); ++i) {
+                for (std::size_t k = 1; k < workers.size(); ++k) workers[i].victims.push_back((i + k) % workers.size());
+                if (placed.workers.empty()) continue;
+                std::stable_sort(workers[i].victims.begin(), workers[i].victims.end(), [&](auto a, auto b) {
+                    return distance(placed.workers[i], placed.workers[a]) < distance(placed.workers[i], placed.workers[b]);
+                });
+            }
+            for (std::size_t i = 0; i < workers.size(); ++i) {
+                workers[i].thread = std::thread([this, i] { run(i); });
+            }
+        }
+
+        ~executor() {
+            stopping.store(true, std::memory_order_seq_cst);
+            wake_seq.fetch_add(1, std::memory_order_release);
+            detail::futex_wake(wake_seq, INT_MAX);
+            for (auto& w: workers) w.thread.join();
+        }
+
+        executor(const executor&) = delete;
+
+        executor& operator=(const executor&) = delete;
+
+        static executor* current() noexcept { return detail::current_executor; }
+
+        std::size_t size() const noexcept { return workers.size(); }
+
+        timer_wheel& timers() noexcept { return wheel; }
+
+        // which cpu each worker is pinned to, and the cores left for a reactor
+        const placement_plan& plan() const noexcept { return placed; }
+
+        // the process-wide counters plus this executor's queue depths and timers
+        runtime_stats stats() {
+            auto s = runtime_stats::collect();
+            for (auto& w: workers) {
+                std::lock_guard lk{w.m};
+                s.worker_queue_depths.push_back(w.q.size() + w.forks.size());
+            }
+            {
+                std::lock_guard lk{global_m};
+                s.global_queue_depth = global.size();
+            }
+            s.timers = wheel.size();
+            return s;
+        }
+
+        void schedule(work_item* w) {
+            work_queue q;
+            q.push_back(w);
+            schedule(q);
+        }
+
+        // a whole waiter list becomes runnable under one lock
+        void schedule(work_queue& q) {
+            if (q.empty()) return;
+            auto n = q.size();
+            if (detail::current_executor == this) {
+                auto& self = workers[detail::current_worker];
+                std::lock_guard lk{self.m};
+                // counted before the items can be popped, so `pending` never wraps
+                pending.fetch_add(n, std::memory_order_relaxed);
+                self.q.splice_back(q);
+            } else {
+                std::lock_guard lk{global_m};
+                pending.fetch_add(n, std::memory_order_relaxed);
+                global.splice_back(q);
+            }
+            wake(n);
+        }
+
+        // `co::fork`: the parent's continuation goes on the bottom of this worker's fork
+        // deque, where thieves can take it from the top while the child runs here
+        // returns the worker it was pushed to, for `take_back`
+        std::size_t push_fork(work_item* w, const void* child) {
+            auto i = detail::current_worker;
+            {
+                std::lock_guard lk{workers[i].m};
+                pending.fetch_add(1, std::memory_order_relaxed);
+                workers[i].forks.push_back({w, child});
+            }
+            wake(1);
+            return i;
+        }
+
+        // the child finished: if nobody took the continuation `w`, the caller runs it
+        // `child` tells this fork from a later one of a stolen parent that reuses `w`
+        bool take_back(std::size_t i, work_item* w, const void* child) {
+            std::lock_guard lk{workers[i].m};
+            auto& forks = workers[i].forks;
+            if (forks.empty() || forks.back().item != w || forks.back().child != child) return false;
+            forks.pop_back();
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // resumes `w` right here when called from one of our own workers, saving the queue
+        // round trip, unless that would nest more than `max_inline_depth` resumes on this
+        // stack; otherwise it is scheduled like any other
+        // the caller must not touch anything `w` may destroy once this returns
+        void dispatch(work_item* w) {
+            auto& depth = detail::inline_depth;
+            if (detail::current_executor != this || depth >= inline_limit.load(std::memory_order_relaxed)) {
+                schedule(w);
+                return;
+            }
+            thread_counters::bump(this_thread_counters().inline_resumes);
+            ++depth;
+            w->handle.resume();
+            --depth;
+        }
+
+        // 0 turns `dispatch` into `schedule`
+        void max_inline_depth(std::size_t n) noexcept { inline_limit.store(n, std::memory_order_relaxed); }
+
+        void spawn(task<> t) {
+            auto d = detail::run_detached(std::move(t));
+            d.handle.promise().item.handle = d.handle;
+            schedule(&d.handle.promise().item);
+        }
+
+        // must not be called from one of our own workers
+        template<class T>
+        T block_on(task<T> t) {
+            detail::task_result<T> out;
+            std::binary_semaphore done{0};
+            spawn(detail::run_and_signal(std::move(t), out, done));
+            done.acquire();
+            return out.get();
+        }
+
+    private:
+        struct fork_slot {
+            work_item* item;
+            const void* child;
+        };
+
+        struct worker {
+            std::mutex m;
+            work_queue q;
+            std::thread thread;
+            std::vector<std::size_t> victims;  // nearest cache first
+            std::deque<fork_slot> forks;  // continuations of forking tasks, newest at the back
+        };
+
+        timer_wheel wheel;
+        std::vector<worker> workers;
+        idle_policy policy;
+        placement_plan placed;
+
+        std::mutex global_m;
+        work_queue global;
+
+        // items in any queue: lets spinners poll without taking a lock
+        std::atomic<std::size_t> pending{0};
+        // parked workers, and the futex word they sleep on
+        std::atomic<std::size_t> idle{0};
+        std::atomic<std::uint32_t> wake_seq{0};
+        std::atomic<bool> stopping{false};
+        std::atomic<std::size_t> inline_limit{16};
+
+        void wake(std::size_t n) {
+            // pairs with the fetch_add in `park`: either we see the sleeper or it sees our work
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto parked = idle.load(std::memory_order_relaxed);
+            if (parked == 0) return;
+            wake_seq.fetch_add(1, std::memory_order_release);
+            detail::futex_wake(wake_seq, static_cast<int>(std::min(n, parked)));
+        }
+
+        work_item* pop(std::mutex& m, work_queue& q) {
+            std::lock_guard lk{m};
+            auto* w = q.pop_front();
+            if (w) pending.fetch_sub(1, std::memory_order_relaxed);
+            return w;
+        }
+
+        // own work newest continuation first, stolen work oldest (i.e. biggest) first
+        work_item* pop_fork(worker& w, bool own) {
+            std::lock_guard lk{w.m};
+            if (w.forks.empty()) return nullptr;
+            auto* item = own ? w.forks.back().item : w.forks.front().item;
+            if (own) {
+                w.forks.pop_back();
+            } else {
+                w.forks.pop_front();
+            }
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            return item;
+        }
+
+        work_item* next(std::size_t i) {
+            if (auto* w = pop_fork(workers[i], true)) return w;
+            if (auto* w = pop(workers[i].m, workers[i].q)) return w;
+            if (auto* w = pop(global_m, global)) return w;
+            for (auto v: workers[i].victims) {
+                auto& victim = workers[v];
+                auto* w = pop_fork(victim, false);
+                if (!w) w = pop(victim.m, victim.q);
+                if (w) {
+                    thread_counters::bump(this_thread_counters().steals);
+                    return w;
+                }
+            }
+            return nullptr;
+        }
+
+        // true: work showed up while spinning
+        bool spin() {
+            unsigned pauses = 1;
+            for (unsigned r = 0; r < policy.spin_rounds; ++r) {
+                if (pending.load(std::memory_order_relaxed) > 0) return true;
+                for (unsigned k = 0; k < pauses; ++k) detail::cpu_relax();
+                pauses = std::min(pauses * 2, policy.max_pause);
+            }
+            return false;
+        }
+
+        // true: keep running
+        bool park() {
+            // read before announcing ourselves: a `wake` after that changes it and the
+            // futex wait below returns at once
+            auto seq = wake_seq.load(std::memory_order_acquire);
+            idle.fetch_add(1, std::memory_order_seq_cst);
+            if (pending.load(std::memory_order_seq_cst) == 0 && !stopping.load(std::memory_order_seq_cst)) {
+                thread_counters::bump(this_thread_counters().parks);
+                detail::futex_wait(wake_seq, seq);
+            }
+            idle.fetch_sub(1, std::memory_order_relaxed);
+            return !stopping.load(std::memory_order_relaxed) || pending.load(std::memory_order_relaxed) > 0;
+        }
+
+        void run(std::size_t i) {
+            detail::current_executor = this;
+            detail::current_worker = i;
+            if (!placed.workers.empty()) pin_this_thread(placed.workers[i].id);
+            auto& counters = this_thread_counters();
+            while (true) {
+                if (auto* w = next(i)) {
+                    thread_counters::bump(counters.resumes);
+                    // `w` lives in the frame being resumed: don't touch it afterwards
+                    w->handle.resume();
+                } else if (spin()) {
+                    continue;
+                } else if (!park()) {
+                    return;
+                }
+            }
+        }
+    };
+
+    /// `co_await co::sleep_for(d)` from a coroutine running on an executor
+    /// `co::sleep_for(d, slack)` may wake up to `slack` late, sharing a wakeup of the
+    /// timer thread with other timers due around then (see `timer_wheel`)
+    /// a stop request on the awaiting task's token cancels the timer and throws
+    /// `operation_cancelled` instead of sleeping on
+    struct sleep_awaitable : timer_node {
+        executor& ex;
+        timer_wheel::clock::duration d;
+        timer_wheel::clock::duration slack;
+        work_item item;
+
+        sleep_awaitable(executor& ex, timer_wheel::clock::duration d, timer_wheel::clock::duration slack = {})
+                : ex(ex), d(d), slack(slack) {}
+
+        bool await_ready() noexcept { return d <= timer_wheel::clock::duration::zero(); }
+
+        template<class P>
+        bool await_suspend(std::coroutine_handle<P> h) {
+            item.handle = h;
+            fire = [](timer_node* n) {
+                auto* self = static_cast<sleep_awaitable*>(n);
+                // still in `await_suspend`: it sees `woken` and doesn't suspend
+                if (self->state.exchange(woken) == suspended) self->ex.schedule(&self->item);
+            };
+            ex.timers().arm(this, d, slack);
+            if constexpr (requires { h.promise().stop; }) {
+                if (h.promise().stop.stop_possible()) on_stop.emplace(h.promise().stop, cancel_fn{this});
+            }
+            // the timer or the stop callback may already have run: then don't suspend at all.
+            // once `suspended` is published, only the one who wakes us touches `this`
+            return state.exchange(suspended) == suspending;
+        }
+
+        void await_resume() {
+            on_stop.reset();
+            if (cancelled) throw operation_cancelled{};
+        }
+
+    private:
+        struct cancel_fn {
+            sleep_awaitable* self;
+
+            void operator()() const noexcept { self->cancel(); }
+        };
+
+        enum { suspending, suspended, woken };
+
+        std::optional<std::stop_callback<cancel_fn>> on_stop;
+        std::atomic<int> state{suspending};
+        bool cancelled = false;
+
+        void cancel() noexcept {
+            // lost the race against the timer: it resumes us normally
+            if (!ex.timers().cancel(this)) return;
+            cancelled = true;
+            if (state.exchange(woken) == suspended) ex.schedule(&item);
+        }
+    };
+
+    inline sleep_awaitable sleep_for(timer_wheel::clock::duration d, timer_wheel::clock::duration slack = {}) {
+        return {*executor::current(), d, slack};
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+
+#include "executor.hpp"
+#include "task.hpp"
+
+/// Cilk-style fork-join inside a `co::task` running on an executor:
+///
+///     long a, b;
+///     co_await co::fork(fib(n - 1), a);
+///     co_await co::fork(fib(n - 2), b);
+///     co_await co::join();
+///     co_return a + b;
+///
+/// `fork` runs the child at once on this worker and leaves the parent's continuation on
+/// the worker's fork deque for an idle worker to steal. when the child finishes and the
+/// continuation is still there, it is taken back and resumed directly: unless there is
+/// something to steal, a fork is one call and nothing is queued, and the recursion runs
+/// depth first, so live frames stay proportional to depth times workers
+///
+/// every fork must be joined before the task returns; `join` rethrows the first exception
+/// a child threw. outside an executor, `fork` simply runs the child to completion
+namespace co {
+    namespace detail {
+        // owns the frame (and the child task in it) until `fork_awaitable` starts it; from
+        // then on the frame destroys itself when done
+        struct forked_t {
+            struct promise_t : counted_frame {
+                std::stop_token stop;
+                join_state* joins = nullptr;
+                std::coroutine_handle<> parent;
+                executor* ex = nullptr;
+                std::size_t worker = 0;
+                work_item* continuation = nullptr;
+
+                forked_t get_return_object() { return forked_t{std::coroutine_handle<promise_t>::from_promise(*this)}; }
+
+                std::suspend_always initial_suspend() noexcept { return {}; }
+
+                struct final_awaitable {
+                    bool await_ready() noexcept { return false; }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept {
+                        auto& p = h.promise();
+                        auto* joins = p.joins;
+                        auto parent = p.parent;
+                        // while this frame is alive its address tells this fork apart
+                        bool mine = !p.ex || p.ex->take_back(p.worker, p.continuation, h.address());
+                        h.destroy();
+                        // taken back the parent cannot be in `join`, so this is never the last count
+                        if (joins->outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1 || mine) return parent;
+                        // stolen and not joined yet: the thief runs the parent, this worker looks for work
+                        return std::noop_coroutine();
+                    }
+
+                    void await_resume() noexcept {}
+                };
+
+                final_awaitable final_suspend() noexcept { return {}; }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept {
+                    if (!joins->failed.exchange(true, std::memory_order_relaxed)) joins->error = std::current_exception();
+                }
+            };
+
+            using promise_type = promise_t;
+            std::coroutine_handle<promise_t> handle;
+
+            explicit forked_t(std::coroutine_handle<promise_t> h) : handle(h) {}
+
+            forked_t(forked_t&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+            // never awaited: the frame never started
+            ~forked_t() {
+                if (handle) handle.destroy();
+            }
+        };
+
+        template<class T>
+        forked_t run_forked(task<T> t, std::conditional_t<std::is_void_v<T>, std::nullptr_t, T*> out) {
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(t);
+            } else {
+                *out = co_await std::move(t);
+            }
+        }
+    }
+
+    struct fork_awaitable : work_item {
+        detail::forked_t child;
+
+        bool await_ready() noexcept { return false; }
+
+        template<class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> parent) {
+            auto& c = child.handle.promise();
+            c.joins = &parent.promise().joins;
+            c.joins->outstanding.fetch_add(1, std::memory_order_relaxed);
+            c.stop = parent.promise().stop;
+            c.parent = parent;
+            handle = parent;
+            auto h = std::exchange(child.handle, {});
+            // once pushed, the parent may be stolen and `this` gone: only locals from here
+            if (auto* ex = executor::current()) {
+                c.ex = ex;
+                c.continuation = this;
+                c.worker = ex->push_fork(this, h.address());
+            }
+            return h;
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    /// `co_await co::fork(child, out)`: `out` receives the result and may be read after `join`
+    template<class T>
+    fork_awaitable fork(task<T> child, T& out) {
+        return {{}, detail::run_forked<T>(std::move(child), &out)};
+    }
+
+    inline fork_awaitable fork(task<> child) { return {{}, detail::run_forked<void>(std::move(child), nullptr)}; }
+
+    struct join_awaitable {
+        detail::join_state* joins = nullptr;
+
+        bool await_ready() noexcept { return false; }
+
+        // drops the task's own count; suspends unless every child has finished already
+        template<class P>
+        bool await_suspend(std::coroutine_handle<P> h) noexcept {
+            joins = &h.promise().joins;
+            return joins->outstanding.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+
+        void await_resume() {
+            joins->outstanding.store(1, std::memory_order_relaxed);
+            if (joins->failed.exchange(false, std::memory_order_relaxed)) {
+                std::rethrow_exception(std::exchange(joins->error, {}));
+            }
+        }
+    };
+
+    inline join_awaitable join() noexcept { return {}; }
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <utility>
+#include <vector>
+
+/// define `CO_TRACK_FRAMES` to register every `task` / `generator` frame; without it the
+/// hooks below compile to nothing
+namespace co {
+    using frame_clock = std::chrono::steady_clock;
+
+    struct frame_info {
+        /// the coroutine's function and file. the line is only near its definition: it is
+        /// resolved when the promise is built, where gcc reports the closing brace
+        std::source_location defined_in;
+        std::source_location last_await;  // default-constructed: never awaited
+        frame_clock::duration since_last_await;
+    };
+
+    namespace detail {
+        struct frame_list;
+
+        /// lives in the promise, linked into the list of the thread that created it
+        struct frame_record {
+            frame_record* prev = nullptr;
+            frame_record* next = nullptr;
+            frame_list* list = nullptr;
+            std::source_location defined_in;
+            // written by the coroutine itself, read by whoever asks for a report
+            std::atomic<std::source_location> last_await{};
+            std::atomic<frame_clock::rep> last_await_at;
+
+            explicit frame_record(std::source_location defined_in)
+                    : defined_in(defined_in), last_await_at(frame_clock::now().time_since_epoch().count()) {}
+
+            frame_info info(frame_clock::time_point now) const {
+                auto at = frame_clock::time_point{frame_clock::duration{last_await_at.load(std::memory_order_relaxed)}};
+                return {defined_in, last_await.load(std::memory_order_relaxed), now - at};
+            }
+        };
+
+        /// one per thread. the lock is uncontended unless a frame dies on another thread
+        /// than it was born on, or a report is being taken
+        struct frame_list {
+            std::mutex m;
+            frame_record* head = nullptr;
+            bool in_use = false;  // guarded by the registry lock
+
+            void link(frame_record* r) {
+                std::lock_guard lk{m};
+                r->list = this;
+                r->next = head;
+                if (head) head->prev = r;
+                head = r;
+            }
+
+            void unlink(frame_record* r) {
+                std::lock_guard lk{m};
+                if (r->prev) {
+                    r->prev->next = r->next;
+                } else {
+                    head = r->next;
+                }
+                if (r->next) r->next->prev = r->prev;
+            }
+        };
+
+        struct frame_list_registry {
+            std::mutex m;
+            std::vector<std::unique_ptr<frame_list>> all;
+
+            frame_list* acquire() {
+                std::lock_guard lk{m};
+                for (auto& l: all) {
+                    if (!l->in_use) {
+                        l->in_use = true;
+                        return l.get();
+                    }
+                }
+                all.push_back(std::make_unique<frame_list>());
+                all.back()->in_use = true;
+                return all.back().get();
+            }
+
+            // frames of an exited thread stay listed: they may well be the leak
+            void release(frame_list* l) {
+                std::lock_guard lk{m};
+                l->in_use = false;
+            }
+
+            std::vector<frame_info> snapshot() {
+                auto now = frame_clock::now();
+                std::vector<frame_info> out;
+                std::lock_guard lk{m};
+                for (auto& l: all) {
+                    std::lock_guard llk{l->m};
+                    for (auto* r = l->head; r; r = r->next) out.push_back(r->info(now));
+                }
+                return out;
+            }
+        };
+
+        inline frame_list_registry& frame_lists() {
+            static auto* r = new frame_list_registry;
+            return *r;
+        }
+
+        struct frame_list_slot {
+            frame_list* l = frame_lists().acquire();
+
+            ~frame_list_slot() { frame_lists().release(l); }
+        };
+
+        inline frame_list& this_thread_frames() {
+            thread_local frame_list_slot slot;
+            return *slot.l;
+        }
+
+#ifdef CO_TRACK_FRAMES
+        /// mixed into promise types. the promise passes the location its own defaulted
+        /// constructor argument resolved to: inside the coroutine, not at its caller, since
+        /// a promise never sees the call
+        struct tracked_frame {
+            frame_record record;
+
+            explicit tracked_frame(std::source_location loc) : record(loc) { this_thread_frames().link(&record); }
+
+            tracked_frame(const tracked_frame&) = delete;
+
+            ~tracked_frame() { record.list->unlink(&record); }
+
+            // sees every `co_await` in the coroutine body, defaulted argument and all
+            template<class A>
+            A&& await_transform(A&& a, std::source_location loc = std::source_location::current()) noexcept {
+                record.last_await.store(loc, std::memory_order_relaxed);
+                record.last_await_at.store(frame_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                return std::forward<A>(a);
+            }
+        };
+#else
+        struct tracked_frame {
+            explicit tracked_frame(std::source_location) noexcept {}
+        };
+#endif
+    }
+
+    /// every registered frame that has not been destroyed yet
+    inline std::vector<frame_info> live_frames() { return detail::frame_lists().snapshot(); }
+
+    /// frames that have not reached a `co_await` for longer than `threshold`
+    inline std::vector<frame_info> stuck_frames(frame_clock::duration threshold) {
+        auto all = live_frames();
+        std::erase_if(all, [&](const frame_info& f) { return f.since_last_await < threshold; });
+        return all;
+    }
+
+    inline std::ostream& operator<<(std::ostream& os, const frame_info& f) {
+        os << f.defined_in.function_name() << " (defined in " << f.defined_in.file_name() << ", body ends at line "
+           << f.defined_in.line() << ")";
+        if (f.last_await.line() != 0) {
+            os << ", last co_await at " << f.last_await.file_name() << ":" << f.last_await.line();
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(f.since_last_await).count();
+        return os << ", " << ms << "ms ago";
+    }
+
+    /// e.g. at the end of `main`: prints every frame still alive, returns how many
+    inline std::size_t report_live_frames(std::ostream& os) {
+        auto all = live_frames();
+        for (auto& f: all) os << "live frame: " << f << "\n";
+        return all.size();
+    }
+}
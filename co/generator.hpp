@@ -0,0 +1,164 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <source_location>
+#include <utility>
+
+#include "frame_registry.hpp"
+#include "stats.hpp"
+
+namespace co {
+    /// `co_yield co::elements_of(child)` yields every element of another generator
+    template<class R>
+    struct elements_of {
+        R range;
+    };
+
+    template<class R>
+    elements_of(R&&) -> elements_of<R&&>;
+
+    /// synchronous generator: `co_yield v` hands out a pointer to `v`, which stays alive in
+    /// the frame until the consumer asks for the next element
+    /// the `yield_value` of `ret_t` in main.cpp, but driven by an input iterator
+    ///
+    /// generators nested with `elements_of` form a stack; the outermost one (`root`) keeps
+    /// the innermost running one (`leaf`), which is what the iterator resumes, so an element
+    /// costs one resume however deep it comes from. a finished child transfers straight
+    /// back to its parent, and an exception escaping it is rethrown from the parent's
+    /// `co_yield`
+    template<class T>
+    struct generator {
+        struct promise_t : detail::counted_frame, detail::tracked_frame {
+            const T* value = nullptr;
+            std::exception_ptr error;
+            promise_t* root = this;
+            promise_t* parent = nullptr;
+            promise_t* leaf = this;  // meaningful in the root only
+
+            promise_t(std::source_location loc = std::source_location::current()) : detail::tracked_frame(loc) {}
+
+            std::coroutine_handle<promise_t> handle() noexcept {
+                return std::coroutine_handle<promise_t>::from_promise(*this);
+            }
+
+            generator get_return_object() { return generator{handle()}; }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct final_awaitable {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept {
+                    auto& p = h.promise();
+                    if (!p.parent) return std::noop_coroutine();
+                    p.root->leaf = p.parent;
+                    return p.parent->handle();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            final_awaitable final_suspend() noexcept { return {}; }
+
+            std::suspend_always yield_value(const T& v) noexcept {
+                root->value = std::addressof(v);
+                return {};
+            }
+
+            template<class R>
+            struct nested_awaitable {
+                R child;
+
+                bool await_ready() noexcept { return !child.handle; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept {
+                    auto& c = child.handle.promise();
+                    c.root = h.promise().root;
+                    c.parent = &h.promise();
+                    c.root->leaf = &c;
+                    return child.handle;
+                }
+
+                void await_resume() {
+                    if (child.handle && child.handle.promise().error) {
+                        std::rethrow_exception(child.handle.promise().error);
+                    }
+                }
+            };
+
+            // `R` is a reference to the child: it lives in the `co_yield` full-expression
+            template<class R>
+                requires std::is_same_v<std::remove_cvref_t<R>, generator>
+            nested_awaitable<R> yield_value(elements_of<R> e) noexcept {
+                return {std::forward<R>(e.range)};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+
+            // a generator never suspends on anything but `co_yield`
+            template<class U>
+            std::suspend_never await_transform(U&&) = delete;
+        };
+
+        /// trait
+        using promise_type = promise_t;
+
+        using handle_t = std::coroutine_handle<promise_type>;
+        handle_t handle;
+
+        struct sentinel {};
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+
+            handle_t h;
+
+            const T& operator*() const { return *h.promise().value; }
+
+            const T* operator->() const { return h.promise().value; }
+
+            iterator& operator++() {
+                h.promise().leaf->handle().resume();
+                if (h.done() && h.promise().error) std::rethrow_exception(h.promise().error);
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& it, sentinel) noexcept { return it.h.done(); }
+        };
+
+        explicit generator(handle_t h) : handle(h) {}
+
+        generator(generator&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+        generator& operator=(generator&& other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        ~generator() {
+            if (handle) handle.destroy();
+        }
+
+        // runs up to the first `co_yield`
+        iterator begin() {
+            iterator it{handle};
+            ++it;
+            return it;
+        }
+
+        sentinel end() const noexcept { return {}; }
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+namespace co {
+    /// singly linked FIFO threaded through the nodes themselves, so queueing never allocates
+    /// `T` only needs a `T* next` member
+    template<class T>
+    struct intrusive_queue {
+        T* head = nullptr;
+        T* tail = nullptr;
+        std::size_t count = 0;
+
+        bool empty() const noexcept { return head == nullptr; }
+
+        std::size_t size() const noexcept { return count; }
+
+        T* front() const noexcept { return head; }
+
+        void push_back(T* n) noexcept {
+            n->next = nullptr;
+            if (tail) {
+                tail->next = n;
+            } else {
+                head = n;
+            }
+            tail = n;
+            ++count;
+        }
+
+        T* pop_front() noexcept {
+            T* n = head;
+            if (n) {
+                head = n->next;
+                if (!head) tail = nullptr;
+                n->next = nullptr;
+                --count;
+            }
+            return n;
+        }
+
+        // move every node of `other` to our back: O(1) whatever the length
+        void splice_back(intrusive_queue& other) noexcept {
+            if (other.empty()) return;
+            if (tail) {
+                tail->next = other.head;
+            } else {
+                head = other.head;
+            }
+            tail = other.tail;
+            count += other.count;
+            other = {};
+        }
+    };
+}
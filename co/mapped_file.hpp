@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace co {
+    /// a whole file mapped read-only, for parsers that hand out views into it instead of
+    /// copying; the pages are read ahead sequentially as the parser walks them
+    struct mapped_file {
+        explicit mapped_file(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) throw std::system_error(errno, std::system_category(), "open " + path);
+            struct stat st{};
+            if (::fstat(fd, &st) < 0) {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::system_category(), "fstat " + path);
+            }
+            size = static_cast<std::size_t>(st.st_size);
+            if (size) {
+                addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr == MAP_FAILED) {
+                    int err = errno;
+                    ::close(fd);
+                    throw std::system_error(err, std::system_category(), "mmap " + path);
+                }
+                ::madvise(addr, size, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+        }
+
+        mapped_file(mapped_file&& other) noexcept
+                : addr(std::exchange(other.addr, nullptr)), size(std::exchange(other.size, 0)) {}
+
+        mapped_file& operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+                if (addr) ::munmap(addr, size);
+                addr = std::exchange(other.addr, nullptr);
+                size = std::exchange(other.size, 0);
+            }
+            return *this;
+        }
+
+        ~mapped_file() {
+            if (addr) ::munmap(addr, size);
+        }
+
+        std::string_view text() const noexcept { return {static_cast<const char*>(addr), size}; }
+
+    private:
+        void* addr = nullptr;
+        std::size_t size = 0;
+    };
+}
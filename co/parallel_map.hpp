@@ -0,0 +1,322 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "async_generator.hpp"
+#include "executor.hpp"
+#include "queue.hpp"
+
+namespace co {
+    /// hands results back in sequence order, however out of order they were `put`
+    ///
+    /// `co_await rb.reserve()` gives the next sequence number, and suspends while `window`
+    /// numbers are reserved but not popped yet, so memory stays bounded even when one slow
+    /// item holds up everything behind it. `put(seq, v)` fills a slot, and
+    /// `co_await rb.pop()` returns the next value in order: nullopt once `close`d and all
+    /// reserved values are out. an exception passed to `fail` is rethrown from `pop`
+    ///
+    /// one consumer; any number of producers
+    template<class T>
+    struct reorder_buffer {
+        reorder_buffer(executor& ex, std::size_t window) : ex(ex), slots(window ? window : 1) {}
+
+        reorder_buffer(const reorder_buffer&) = delete;
+
+        reorder_buffer& operator=(const reorder_buffer&) = delete;
+
+        struct reserve_awaitable : work_item {
+            reorder_buffer& rb;
+            std::uint64_t seq = 0;
+            bool ok = true;
+
+            explicit reserve_awaitable(reorder_buffer& rb) : rb(rb) {}
+
+            bool await_ready() { return rb.try_reserve(*this); }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return rb.reserve_slow(this);
+            }
+
+            // nullopt once closed
+            std::optional<std::uint64_t> await_resume() noexcept {
+                if (!ok) return std::nullopt;
+                return seq;
+            }
+        };
+
+        struct pop_awaitable : work_item {
+            reorder_buffer& rb;
+            std::optional<T> value;
+
+            explicit pop_awaitable(reorder_buffer& rb) : rb(rb) {}
+
+            bool await_ready() { return rb.try_pop(*this); }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return rb.pop_slow(this);
+            }
+
+            std::optional<T> await_resume() {
+                if (!value && rb.error) std::rethrow_exception(rb.error);
+                return std::move(value);
+            }
+        };
+
+        reserve_awaitable reserve() { return reserve_awaitable{*this}; }
+
+        pop_awaitable pop() { return pop_awaitable{*this}; }
+
+        void put(std::uint64_t seq, T value) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                slots[seq % slots.size()].emplace(std::move(value));
+                if (consumer && seq == next_out) deliver_locked(ready);
+            }
+            ex.schedule(ready);
+        }
+
+        // pending reservations fail; what was reserved before is still delivered
+        void close() {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                closed = true;
+                fail_reservers_locked(ready);
+                if (consumer && next_out == next_seq) deliver_locked(ready);
+            }
+            ex.schedule(ready);
+        }
+
+        // the consumer gets `e` instead of the remaining values
+        void fail(std::exception_ptr e) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (!error) error = std::move(e);
+                closed = true;
+                fail_reservers_locked(ready);
+                if (consumer) deliver_locked(ready);
+            }
+            ex.schedule(ready);
+        }
+
+    private:
+        executor& ex;
+        std::mutex m;
+        std::vector<std::optional<T>> slots;
+        std::uint64_t next_seq = 0;  // the next to reserve
+        std::uint64_t next_out = 0;  // the next to pop
+        work_queue reservers;
+        pop_awaitable* consumer = nullptr;
+        bool closed = false;
+        std::exception_ptr error;
+
+        bool has_room_locked() const { return next_seq - next_out < slots.size(); }
+
+        bool try_reserve(reserve_awaitable& r) {
+            std::lock_guard lk{m};
+            if (closed) {
+                r.ok = false;
+                return true;
+            }
+            if (!reservers.empty() || !has_room_locked()) return false;
+            r.seq = next_seq++;
+            return true;
+        }
+
+        // false: room appeared in the meantime, don't suspend
+        bool reserve_slow(reserve_awaitable* r) {
+            std::lock_guard lk{m};
+            if (closed) {
+                r->ok = false;
+                return false;
+            }
+            if (!reservers.empty() || !has_room_locked()) {
+                reservers.push_back(r);
+                return true;
+            }
+            r->seq = next_seq++;
+            return false;
+        }
+
+        void fail_reservers_locked(work_queue& ready) {
+            while (auto* r = reservers.pop_front()) {
+                static_cast<reserve_awaitable*>(r)->ok = false;
+                ready.push_back(r);
+            }
+        }
+
+        bool ready_locked() const {
+            return error || slots[next_out % slots.size()] || (closed && next_out == next_seq);
+        }
+
+        // fills `c` with the next value, or leaves it empty at the end; wakes a reserver
+        void take_locked(pop_awaitable& c, work_queue& ready) {
+            auto& slot = slots[next_out % slots.size()];
+            if (error || !slot) return;
+            c.value = std::move(slot);
+            slot.reset();
+            ++next_out;
+            if (auto* r = static_cast<reserve_awaitable*>(reservers.pop_front())) {
+                r->seq = next_seq++;
+                ready.push_back(r);
+            }
+        }
+
+        void deliver_locked(work_queue& ready) {
+            auto* c = std::exchange(consumer, nullptr);
+            take_locked(*c, ready);
+            ready.push_back(c);
+        }
+
+        bool try_pop(pop_awaitable& c) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (!ready_locked()) return false;
+                take_locked(c, ready);
+            }
+            ex.schedule(ready);
+            return true;
+        }
+
+        bool pop_slow(pop_awaitable* c) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (!ready_locked()) {
+                    consumer = c;
+                    return true;
+                }
+                take_locked(*c, ready);
+            }
+            ex.schedule(ready);
+            return false;
+        }
+    };
+
+    struct parallel_options {
+        std::size_t instances = 4;  // coroutines running the stage at once
+        std::size_t window = 0;  // items between the source and the consumer; 0 is 2 * instances
+    };
+
+    namespace detail {
+        template<class R>
+        struct stage_result {
+            using type = R;
+            static constexpr bool awaited = false;
+        };
+
+        template<class R>
+        struct stage_result<task<R>> {
+            using type = R;
+            static constexpr bool awaited = true;
+        };
+
+        template<class T, class F>
+        using stage_t = stage_result<std::invoke_result_t<F&, T>>;
+
+        template<class T, class F>
+        struct parallel_state {
+            using R = typename stage_t<T, F>::type;
+
+            struct job {
+                std::uint64_t seq = 0;
+                std::optional<T> value;
+            };
+
+            F f;
+            async_queue<job> in;
+            reorder_buffer<R> out;
+
+            parallel_state(executor& ex, F f, std::size_t instances, std::size_t window)
+                    : f(std::move(f)), in(ex, instances), out(ex, window) {}
+
+            void stop() {
+                in.close();
+                out.close();
+            }
+        };
+
+        // the only one resuming the source: numbers every item, in order, as it goes out
+        template<class T, class F>
+        task<> feed_stage(std::shared_ptr<parallel_state<T, F>> s, async_generator<T> source) {
+            try {
+                while (auto* v = co_await source.next()) {
+                    auto seq = co_await s->out.reserve();
+                    if (!seq) break;
+                    typename parallel_state<T, F>::job j{*seq, *v};
+                    if (!co_await s->in.push(std::move(j))) break;
+                }
+            } catch (...) {
+                s->out.fail(std::current_exception());
+            }
+            s->in.close();
+            s->out.close();
+        }
+
+        template<class T, class F>
+        task<> run_stage(std::shared_ptr<parallel_state<T, F>> s) {
+            typename parallel_state<T, F>::job j[1];
+            while (co_await s->in.pop_batch(j, 1)) {
+                try {
+                    if constexpr (stage_t<T, F>::awaited) {
+                        s->out.put(j[0].seq, co_await std::invoke(s->f, std::move(*j[0].value)));
+                    } else {
+                        s->out.put(j[0].seq, std::invoke(s->f, std::move(*j[0].value)));
+                    }
+                } catch (...) {
+                    s->out.fail(std::current_exception());
+                }
+            }
+        }
+    }
+
+    /// `f` applied to every item of `source` by `instances` coroutines at once, with the
+    /// results coming out in source order:
+    ///
+    ///     auto parsed = co::parallel_map(read_blocks(fd), parse, {.instances = 8});
+    ///     while (auto* b = co_await parsed.next()) co_await write(*b);
+    ///
+    /// `f` takes an item and returns a result or a `co::task` of one; it is called from
+    /// several workers at once, so it must not keep state of its own. a result that is
+    /// done early waits in a `reorder_buffer` of `window` slots until those before it are
+    /// out. that bounds memory, and also how far a slow item can hold the others back
+    ///
+    /// items are copied out of `source`. an exception from `f` or from the source ends the
+    /// stream and is rethrown from `next()`. must be consumed on an executor worker, where
+    /// the instances are spawned
+    template<class T, class F>
+    async_generator<typename detail::stage_t<T, F>::type> parallel_map(async_generator<T> source, F f,
+                                                                       parallel_options opts = {}) {
+        auto* ex = executor::current();
+        if (!ex) throw std::logic_error("co::parallel_map must be consumed on an executor worker");
+        auto instances = opts.instances ? opts.instances : 1;
+        auto s = std::make_shared<detail::parallel_state<T, F>>(*ex, std::move(f), instances,
+                                                                opts.window ? opts.window : 2 * instances);
+        // also when the consumer stops early: the feeder and the instances wind down
+        struct stopper {
+            detail::parallel_state<T, F>& s;
+
+            ~stopper() { s.stop(); }
+        } guard{*s};
+
+        ex->spawn(detail::feed_stage(s, std::move(source)));
+        for (std::size_t i = 0; i < instances; ++i) ex->spawn(detail::run_stage(s));
+        while (auto v = co_await s->out.pop()) co_yield *v;
+    }
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <utility>
+
+#include "executor.hpp"
+
+namespace co {
+    /// bounded MPMC queue
+    ///
+    /// `co_await q.push(v)` suspends while the queue is full; false once closed
+    /// `co_await q.pop_batch(out, max, linger)` moves up to `max` items into `out` and
+    /// returns how many, suspending only while the queue is empty. with a `linger`, the
+    /// consumer keeps waiting up to that long after the first item shows up, so it can
+    /// collect a fuller batch: one suspension is amortized over the whole batch
+    /// 0 means closed and drained
+    ///
+    /// consumers are served in FIFO order; the front one collects items for its batch
+    template<class T>
+    struct async_queue {
+        using clock = timer_wheel::clock;
+
+        async_queue(executor& ex, std::size_t capacity) : ex(ex), capacity(capacity ? capacity : 1) {}
+
+        async_queue(const async_queue&) = delete;
+
+        async_queue& operator=(const async_queue&) = delete;
+
+        struct push_awaitable : work_item {
+            async_queue& q;
+            T value;
+            bool ok = true;
+
+            push_awaitable(async_queue& q, T value) : q(q), value(std::move(value)) {}
+
+            bool await_ready() { return q.try_push(*this); }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return q.push_slow(this);
+            }
+
+            bool await_resume() noexcept { return ok; }
+        };
+
+        struct pop_awaitable : work_item {
+            struct linger_timer_t : timer_node {
+                pop_awaitable* self = nullptr;
+            };
+
+            async_queue& q;
+            std::span<T> out;
+            std::size_t want;
+            clock::duration linger;
+            std::size_t taken = 0;
+            bool done = false;
+            bool armed = false;
+            linger_timer_t timer;
+
+            pop_awaitable(async_queue& q, std::span<T> out, std::size_t max, clock::duration linger)
+                    : q(q), out(out.first(std::min(max, out.size()))), want(this->out.size()), linger(linger) {
+                timer.self = this;
+                timer.fire = [](timer_node* n) { static_cast<linger_timer_t*>(n)->self->on_linger(); };
+            }
+
+            bool await_ready() { return q.try_pop(*this); }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return q.pop_slow(this);
+            }
+
+            std::size_t await_resume() noexcept { return taken; }
+
+        private:
+            void on_linger() { q.linger_expired(this); }
+        };
+
+        push_awaitable push(T value) { return {*this, std::move(value)}; }
+
+        pop_awaitable pop_batch(std::span<T> out, std::size_t max, clock::duration linger = {}) {
+            return {*this, out, max, linger};
+        }
+
+        // wakes everyone: pending pushes fail, consumers drain what is left
+        void close() {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                closed = true;
+                while (auto* p = producers.pop_front()) {
+                    static_cast<push_awaitable*>(p)->ok = false;
+                    ready.push_back(p);
+                }
+                feed_locked(ready);
+            }
+            ex.schedule(ready);
+        }
+
+        std::size_t size() {
+            std::lock_guard lk{m};
+            return items.size();
+        }
+
+    private:
+        executor& ex;
+        const std::size_t capacity;
+
+        std::mutex m;
+        std::deque<T> items;
+        work_queue producers;
+        work_queue consumers;
+        bool closed = false;
+
+        bool try_push(push_awaitable& p) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (closed) {
+                    p.ok = false;
+                    return true;
+                }
+                if (!producers.empty() || items.size() >= capacity) return false;
+                items.push_back(std::move(p.value));
+                feed_locked(ready);
+            }
+            ex.schedule(ready);
+            return true;
+        }
+
+        // false: room appeared in the meantime, don't suspend
+        bool push_slow(push_awaitable* p) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (closed) {
+                    p->ok = false;
+                    return false;
+                }
+                if (!producers.empty() || items.size() >= capacity) {
+                    producers.push_back(p);
+                    return true;
+                }
+                items.push_back(std::move(p->value));
+                feed_locked(ready);
+            }
+            ex.schedule(ready);
+            return false;
+        }
+
+        bool try_pop(pop_awaitable& c) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (!ready_now_locked(c)) return false;
+                take_locked(c, ready);
+            }
+            ex.schedule(ready);
+            return true;
+        }
+
+        bool pop_slow(pop_awaitable* c) {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (ready_now_locked(*c)) {
+                    take_locked(*c, ready);
+                } else {
+                    consumers.push_back(c);
+                    if (consumers.front() == c && !items.empty()) arm_locked(c);
+                    return true;
+                }
+            }
+            ex.schedule(ready);
+            return false;
+        }
+
+        bool ready_now_locked(pop_awaitable& c) const {
+            if (!consumers.empty()) return false;
+            if (c.want == 0 || closed || items.size() >= c.want) return true;
+            return !items.empty() && c.linger <= clock::duration::zero();
+        }
+
+        void arm_locked(pop_awaitable* c) {
+            if (c->armed || c->linger <= clock::duration::zero()) return;
+            c->armed = true;
+            ex.timers().arm(&c->timer, c->linger);
+        }
+
+        // fills `c` from the buffer, then refills the buffer from blocked producers
+        void take_locked(pop_awaitable& c, work_queue& ready) {
+            auto n = std::min(c.want, items.size());
+            std::move(items.begin(), items.begin() + static_cast<std::ptrdiff_t>(n), c.out.begin());
+            items.erase(items.begin(), items.begin() + static_cast<std::ptrdiff_t>(n));
+            c.taken = n;
+            c.done = true;
+            while (items.size() < capacity && !producers.empty()) {
+                auto* p = static_cast<push_awaitable*>(producers.pop_front());
+                items.push_back(std::move(p->value));
+                ready.push_back(p);
+            }
+        }
+
+        // completes waiting consumers whose batch is due; called after items arrive
+        void feed_locked(work_queue& ready) {
+            while (auto* c = static_cast<pop_awaitable*>(consumers.front())) {
+                bool due = closed || items.size() >= c->want
+                           || (!items.empty() && c->linger <= clock::duration::zero());
+                if (!due) {
+                    if (!items.empty()) arm_locked(c);
+                    return;
+                }
+                consumers.pop_front();
+                take_locked(*c, ready);
+                // if the linger timer is already firing, `linger_expired` resumes `c`
+                if (!c->armed || ex.timers().cancel(&c->timer)) {
+                    c->armed = false;
+                    ready.push_back(c);
+                }
+            }
+        }
+
+        void linger_expired(pop_awaitable* c) {
+            auto& e = ex;
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                c->armed = false;
+                if (!c->done) {
+                    // still the front consumer: it was armed, so items are there
+                    consumers.pop_front();
+                    take_locked(*c, ready);
+                    feed_locked(ready);
+                }
+                ready.push_back(c);
+            }
+            e.schedule(ready);
+        }
+    };
+}
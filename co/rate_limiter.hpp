@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+
+#include "executor.hpp"
+
+namespace co {
+    /// token bucket: bursts of up to `capacity`, refilled at `rate` tokens per second
+    ///
+    /// `co_await limiter.acquire(n)` takes tokens with a single `fetch_sub`. the counter is
+    /// allowed to go negative: whoever drives it below zero owes that debt and queues
+    /// (intrusively, inside its own frame) until refills pay it back. refills are computed
+    /// lazily from elapsed time and, while anyone waits, by one timer on the wheel
+    ///
+    /// the limiter must outlive every pending `acquire`
+    struct rate_limiter {
+        using clock = std::chrono::steady_clock;
+
+        rate_limiter(executor& ex, std::int64_t capacity, double rate)
+                : ex(ex), capacity(capacity), rate(rate), tokens(capacity), last(clock::now()) {
+            refill_timer.owner = this;
+            refill_timer.fire = [](timer_node* n) {
+                static_cast<refill_timer_t*>(n)->owner->on_timer();
+            };
+        }
+
+        // a refill the wheel has already taken off may be on its way into `on_timer`, on
+        // the driver thread: that one is waited for
+        ~rate_limiter() {
+            std::unique_lock lk{m};
+            if (armed && !ex.timers().cancel(&refill_timer)) {
+                closing = true;
+                disarmed.wait(lk, [this] { return !armed; });
+            }
+        }
+
+        rate_limiter(const rate_limiter&) = delete;
+
+        rate_limiter& operator=(const rate_limiter&) = delete;
+
+        struct acquire_awaitable : work_item {
+            rate_limiter& rl;
+            std::int64_t n;
+            std::int64_t debt = 0;
+
+            acquire_awaitable(rate_limiter& rl, std::int64_t n) : rl(rl), n(n) {}
+
+            // fast path: tokens were there
+            bool await_ready() noexcept {
+                auto left = rl.tokens.fetch_sub(n, std::memory_order_acq_rel) - n;
+                count_fast_path(fast_path::rate_limiter, left >= 0);
+                if (left >= 0) return true;
+                debt = std::min(n, -left);
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return rl.wait(this);
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        acquire_awaitable acquire(std::int64_t n = 1) { return {*this, n}; }
+
+        // may be negative while acquisitions are queued
+        std::int64_t available() const noexcept { return tokens.load(std::memory_order_relaxed); }
+
+    private:
+        struct refill_timer_t : timer_node {
+            rate_limiter* owner = nullptr;
+        };
+
+        executor& ex;
+        const std::int64_t capacity;
+        const double rate;
+        std::atomic<std::int64_t> tokens;
+
+        std::mutex m;
+        clock::time_point last;
+        work_queue waiters;
+        std::int64_t queued_debt = 0;
+        refill_timer_t refill_timer;
+        bool armed = false;
+        bool closing = false;  // the destructor waits on `disarmed`
+        std::condition_variable disarmed;
+
+        void refill_locked() {
+            auto now = clock::now();
+            auto add = static_cast<std::int64_t>(std::chrono::duration<double>(now - last).count() * rate);
+            if (add <= 0) return;
+            // only advance by what was paid out, so fractional tokens aren't lost
+            last += std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(add / rate));
+            auto t = tokens.load(std::memory_order_relaxed);
+            while (!tokens.compare_exchange_weak(t, std::min(t + add, capacity), std::memory_order_acq_rel)) {}
+        }
+
+        // moves every waiter whose debt is covered onto `ready`, stopping at `self`
+        // true: `self` is covered as well
+        bool release_locked(work_queue& ready, work_item* self) {
+            // debt not yet paid back, summed over the queue; anything else already refilled
+            auto covered = queued_debt + tokens.load(std::memory_order_acquire);
+            while (!waiters.empty()) {
+                auto* w = static_cast<acquire_awaitable*>(waiters.front());
+                if (w->debt > covered) break;
+                covered -= w->debt;
+                queued_debt -= w->debt;
+                waiters.pop_front();
+                if (w == self) return true;
+                ready.push_back(w);
+            }
+            return false;
+        }
+
+        void arm_locked() {
+            if (armed || waiters.empty()) return;
+            auto* front = static_cast<acquire_awaitable*>(waiters.front());
+            auto missing = front->debt - (queued_debt + tokens.load(std::memory_order_acquire));
+            auto wait = std::chrono::duration<double>(static_cast<double>(std::max<std::int64_t>(missing, 1)) / rate);
+            armed = true;
+            ex.timers().arm(&refill_timer, std::chrono::duration_cast<clock::duration>(wait));
+        }
+
+        // slow path. false: don't suspend after all
+        bool wait(acquire_awaitable* w) {
+            auto& e = ex;
+            work_queue ready;
+            bool self_ready;
+            {
+                std::lock_guard lk{m};
+                refill_locked();
+                waiters.push_back(w);
+                queued_debt += w->debt;
+                self_ready = release_locked(ready, w);
+                arm_locked();
+            }
+            e.schedule(ready);
+            return !self_ready;
+        }
+
+        void on_timer() {
+            auto& e = ex;
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                armed = false;
+                refill_locked();
+                release_locked(ready, nullptr);
+                arm_locked();
+                // under the lock: the destructor can't get past it before we're done
+                if (closing) disarmed.notify_all();
+            }
+            // nothing of `this` is touched from here on: a released waiter may destroy us
+            e.schedule(ready);
+        }
+    };
+}
@@ -0,0 +1,959 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "executor.hpp"
+#include "intrusive.hpp"
+#include "stats.hpp"
+#include "topology.hpp"
+
+/// io_uring without liburing: one ring per `reactor`, driven by its own thread
+///
+///     co::reactor io{ex};
+///     int n = co_await io.read(fd, buf);                       // bytes, or -errno
+///     auto [w, s] = co_await co::link(io.write(fd, out, 0), io.fsync(fd));
+///     int fd = co_await io.openat(AT_FDCWD, "log", O_WRONLY | O_CREAT, 0644);
+///     auto conns = io.accept_multishot(listener);
+///     while (auto fd = co_await conns.next()) ...
+///
+/// awaiting an operation only queues its sqe. the reactor thread moves everything queued
+/// since it last looked into the ring and submits it with the same `io_uring_enter` that
+/// waits for completions, so a burst of operations from any number of coroutines costs
+/// one syscall, plus one eventfd write if the reactor was asleep. completions are handed
+/// back to the executor in one batch per `io_uring_enter` as well
+///
+/// a stop request on the awaiting task's token sends an `IORING_OP_ASYNC_CANCEL` for the
+/// operation, or for every sqe of a `link`; one the kernel cancelled throws
+/// `operation_cancelled` instead of resuming with `-ECANCELED`
+///
+/// every operation must have completed before the reactor is destroyed; multishot ones
+/// end after `cancel()`
+namespace co {
+    namespace detail {
+        inline int io_uring_setup(unsigned entries, io_uring_params* p) {
+            return static_cast<int>(syscall(SYS_io_uring_setup, entries, p));
+        }
+
+        inline int io_uring_enter(int fd, unsigned submit, unsigned min_complete, unsigned flags) {
+            return static_cast<int>(syscall(SYS_io_uring_enter, fd, submit, min_complete, flags, nullptr, 0));
+        }
+
+        inline int io_uring_register(int fd, unsigned op, void* arg, unsigned n) {
+            return static_cast<int>(syscall(SYS_io_uring_register, fd, op, arg, n));
+        }
+
+        [[noreturn]] inline void throw_errno(const char* what) {
+            throw std::system_error(errno, std::system_category(), what);
+        }
+
+        template<class T>
+        T load_acquire(T* p) noexcept {
+            return std::atomic_ref<T>(*p).load(std::memory_order_acquire);
+        }
+
+        template<class T>
+        void store_release(T* p, T v) noexcept {
+            std::atomic_ref<T>(*p).store(v, std::memory_order_release);
+        }
+
+        // the mmapped submission and completion rings; only the reactor thread touches them
+        struct uring {
+            int fd = -1;
+            io_uring_params params{};
+
+            explicit uring(unsigned entries) {
+                // COOP_TASKRUN needs 5.19; older kernels say EINVAL and get the default
+                params.flags = IORING_SETUP_COOP_TASKRUN;
+                fd = io_uring_setup(entries, &params);
+                if (fd < 0 && errno == EINVAL) {
+                    params = {};
+                    fd = io_uring_setup(entries, &params);
+                }
+                if (fd < 0) throw_errno("io_uring_setup");
+
+                sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                if (params.features & IORING_FEAT_SINGLE_MMAP) sq_size = cq_size = std::max(sq_size, cq_size);
+                sq_ring = map(sq_size, IORING_OFF_SQ_RING);
+                cq_ring = params.features & IORING_FEAT_SINGLE_MMAP ? sq_ring : map(cq_size, IORING_OFF_CQ_RING);
+                sqes = static_cast<io_uring_sqe*>(map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+
+                auto at = [](void* base, unsigned off) { return reinterpret_cast<unsigned*>(static_cast<char*>(base) + off); };
+                sq_head = at(sq_ring, params.sq_off.head);
+                sq_tail = at(sq_ring, params.sq_off.tail);
+                sq_mask = *at(sq_ring, params.sq_off.ring_mask);
+                cq_head = at(cq_ring, params.cq_off.head);
+                cq_tail = at(cq_ring, params.cq_off.tail);
+                cq_mask = *at(cq_ring, params.cq_off.ring_mask);
+                cqes = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cq_ring) + params.cq_off.cqes);
+                // slot i of the index array always names sqe i
+                auto* array = at(sq_ring, params.sq_off.array);
+                for (unsigned i = 0; i < params.sq_entries; ++i) array[i] = i;
+                tail = *sq_tail;
+            }
+
+            ~uring() {
+                munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+                if (cq_ring != sq_ring) munmap(cq_ring, cq_size);
+                munmap(sq_ring, sq_size);
+                close(fd);
+            }
+
+            uring(const uring&) = delete;
+
+            uring& operator=(const uring&) = delete;
+
+            unsigned space() const noexcept { return params.sq_entries - (tail - load_acquire(sq_head)); }
+
+            unsigned capacity() const noexcept { return params.sq_entries; }
+
+            // the caller checked `space()`
+            io_uring_sqe* next_sqe() noexcept { return &sqes[tail++ & sq_mask]; }
+
+            // makes every sqe from `next_sqe` visible to the kernel
+            void publish() noexcept { store_release(sq_tail, tail); }
+
+            template<class F>
+            unsigned reap(F f) {
+                unsigned head = *cq_head;
+                unsigned end = load_acquire(cq_tail);
+                unsigned n = end - head;
+                for (; head != end; ++head) f(cqes[head & cq_mask]);
+                store_release(cq_head, head);
+                return n;
+            }
+
+        private:
+            void* sq_ring = nullptr;
+            void* cq_ring = nullptr;
+            io_uring_sqe* sqes = nullptr;
+            std::size_t sq_size = 0;
+            std::size_t cq_size = 0;
+            unsigned* sq_head = nullptr;
+            unsigned* sq_tail = nullptr;
+            unsigned sq_mask = 0;
+            unsigned* cq_head = nullptr;
+            unsigned* cq_tail = nullptr;
+            unsigned cq_mask = 0;
+            io_uring_cqe* cqes = nullptr;
+            unsigned tail = 0;  // ours, published by `publish`
+
+            void* map(std::size_t n, std::uint64_t off) {
+                void* p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, static_cast<off_t>(off));
+                if (p == MAP_FAILED) throw_errno("io_uring mmap");
+                return p;
+            }
+        };
+    }
+
+    /// one submission: the sqe as prepared, and what to do with each of its completions
+    /// `complete` runs on the reactor thread; pushing a `work_item` onto `ready` resumes it
+    /// on the executor once the whole batch of completions has been reaped
+    struct io_op : work_item {
+        io_uring_sqe sqe{};
+        int res = 0;
+        void (*complete)(io_op* self, int res, std::uint32_t flags, work_queue& ready) = resume_awaiter;
+
+        static void resume_awaiter(io_op* self, int res, std::uint32_t, work_queue& ready) {
+            self->res = res;
+            ready.push_back(self);
+        }
+    };
+
+    struct reactor;
+
+    namespace detail {
+        struct cancel_fn {
+            void* self;
+            void (*fn)(void*) noexcept;
+
+            void operator()() const noexcept { fn(self); }
+        };
+
+        /// who resumes a cancellable operation: its completion, `await_suspend` publishing
+        /// that it suspended, and the completion of any `ASYNC_CANCEL` aimed at it each
+        /// set a bit, and the one setting the last of them resumes the awaiter. an op is
+        /// never resumed, and its memory never freed, while a cancel for it is in flight
+        struct cancel_state {
+            enum : unsigned { suspended = 1, done = 2, cancel_sent = 4, cancel_done = 8 };
+
+            std::atomic<unsigned> bits{0};
+            std::size_t cancels_left = 0;  // counted down on the reactor thread only
+            std::optional<std::stop_callback<cancel_fn>> on_stop;
+
+            cancel_state() = default;
+
+            // ops are copied while they are being prepared, never once awaited
+            cancel_state(const cancel_state&) noexcept {}
+
+            cancel_state& operator=(const cancel_state&) noexcept { return *this; }
+
+            // true: the awaiter may run now
+            bool set(unsigned bit) noexcept {
+                auto b = bits.fetch_or(bit, std::memory_order_acq_rel) | bit;
+                return (b & suspended) && (b & done) && (!(b & cancel_sent) || (b & cancel_done));
+            }
+
+            // false: it completed already, there is nothing to cancel
+            bool begin_cancel(std::size_t n) noexcept {
+                auto b = bits.load(std::memory_order_acquire);
+                do {
+                    if (b & (done | cancel_sent)) return false;
+                } while (!bits.compare_exchange_weak(b, b | cancel_sent, std::memory_order_acq_rel,
+                                                     std::memory_order_acquire));
+                cancels_left = n;
+                return true;
+            }
+
+            // stopped before anything was submitted: the awaiter carries on at once
+            void cancel_unsubmitted() noexcept { bits.store(done | cancel_sent | cancel_done, std::memory_order_relaxed); }
+
+            bool cancelled() const noexcept { return bits.load(std::memory_order_relaxed) & cancel_sent; }
+        };
+
+        /// an `ASYNC_CANCEL` for one sqe, reporting back to `owner`'s `cancel_state`
+        struct cancel_op : io_op {
+            work_item* owner = nullptr;
+            cancel_state* state = nullptr;
+
+            void prepare(work_item* owner, cancel_state& state, io_op* target) {
+                this->owner = owner;
+                this->state = &state;
+                sqe.opcode = IORING_OP_ASYNC_CANCEL;
+                sqe.fd = -1;
+                sqe.addr = reinterpret_cast<std::uint64_t>(target);
+                complete = [](io_op* self, int, std::uint32_t, work_queue& ready) {
+                    auto* c = static_cast<cancel_op*>(self);
+                    if (--c->state->cancels_left == 0 && c->state->set(cancel_state::cancel_done)) {
+                        ready.push_back(c->owner);
+                    }
+                };
+            }
+        };
+
+        inline bool cancelled_res(int res) noexcept { return res == -ECANCELED || res == -EINTR; }
+    }
+
+    /// a prepared operation: nothing is submitted until it is awaited
+    /// resumes with the cqe's `res`, i.e. a byte count, a new fd or `-errno`
+    struct io_awaitable : io_op {
+        reactor* r;
+        detail::cancel_state cancel;
+        detail::cancel_op cancel_sqe;
+
+        bool await_ready() noexcept { return false; }
+
+        template<class P>
+        bool await_suspend(std::coroutine_handle<P> h);
+
+        int await_resume() {
+            cancel.on_stop.reset();
+            if (cancel.cancelled() && detail::cancelled_res(res)) throw operation_cancelled{};
+            return res;
+        }
+
+    private:
+        static void request_cancel(void* p) noexcept;
+    };
+
+    struct reactor_options {
+        unsigned entries = 256;
+        // pins the reactor thread to the first of the executor's `reserved_cores`, if any
+        bool pin = true;
+    };
+
+    struct buffer_pool;
+    struct accept_stream;
+    struct recv_stream;
+
+    struct reactor {
+        explicit reactor(executor& ex, reactor_options opts = {}) : ex(ex), ring(opts.entries) {
+            wake_fd = eventfd(0, EFD_CLOEXEC);
+            if (wake_fd < 0) detail::throw_errno("eventfd");
+            wake_op.sqe.opcode = IORING_OP_READ;
+            wake_op.sqe.fd = wake_fd;
+            wake_op.sqe.addr = reinterpret_cast<std::uint64_t>(&wake_buf);
+            wake_op.sqe.len = sizeof(wake_buf);
+            wake_op.complete = [](io_op* self, int, std::uint32_t, work_queue&) {
+                // runs on the reactor thread itself: re-arming never needs a wakeup
+                auto* r = static_cast<wake_op_t*>(self)->r;
+                std::lock_guard lk{r->m};
+                r->pending.push_back(self);
+            };
+            wake_op.r = this;
+            pending.push_back(&wake_op);
+            int cpu = opts.pin && !ex.plan().reserved.empty() ? ex.plan().reserved.front().id : -1;
+            thread = std::thread([this, cpu] {
+                if (cpu >= 0) pin_this_thread(cpu);
+                run();
+            });
+        }
+
+        ~reactor() {
+            stopping.store(true, std::memory_order_seq_cst);
+            {
+                std::lock_guard lk{m};
+                signal();
+            }
+            thread.join();
+            close(wake_fd);
+        }
+
+        reactor(const reactor&) = delete;
+
+        reactor& operator=(const reactor&) = delete;
+
+        executor& owner() noexcept { return ex; }
+
+        int ring_fd() const noexcept { return ring.fd; }
+
+        // the executor's stats plus operations the kernel has not completed yet
+        runtime_stats stats() {
+            auto s = ex.stats();
+            s.io_in_flight = in_flight.load(std::memory_order_relaxed);
+            return s;
+        }
+
+        /// queues `n` ops in order, with nothing in between; a linked chain relies on that
+        /// safe from any thread, including `complete` callbacks on the reactor thread
+        /// a linked chain longer than the whole ring could never go in: that throws
+        void submit(io_op* const* ops, std::size_t n) {
+            std::size_t chain = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                chain = ops[i]->sqe.flags & IOSQE_IO_LINK ? chain + 1 : 0;
+                if (chain >= ring.capacity()) throw std::invalid_argument("co::reactor: linked chain longer than the ring");
+            }
+            // the wakeup is under the lock as well: the ops cannot reach the ring, complete
+            // and let their owner destroy the reactor before we are done with it
+            std::lock_guard lk{m};
+            for (std::size_t i = 0; i < n; ++i) pending.push_back(ops[i]);
+            // pairs with the fence in `run`: either it sees the ops or we see it asleep
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed)) signal();
+        }
+
+        void submit(io_op* op) { submit(&op, 1); }
+
+        io_awaitable nop() { return prep(IORING_OP_NOP, -1, nullptr, 0, 0); }
+
+        // `offset` -1 reads at (and advances) the file position
+        io_awaitable read(int fd, std::span<std::byte> buf, std::uint64_t offset = -1) {
+            return prep(IORING_OP_READ, fd, buf.data(), static_cast<unsigned>(buf.size()), offset);
+        }
+
+        io_awaitable write(int fd, std::span<const std::byte> buf, std::uint64_t offset = -1) {
+            return prep(IORING_OP_WRITE, fd, buf.data(), static_cast<unsigned>(buf.size()), offset);
+        }
+
+        io_awaitable fsync(int fd, bool data_only = false) {
+            auto a = prep(IORING_OP_FSYNC, fd, nullptr, 0, 0);
+            if (data_only) a.sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+            return a;
+        }
+
+        io_awaitable recv(int fd, std::span<std::byte> buf, int flags = 0) {
+            auto a = prep(IORING_OP_RECV, fd, buf.data(), static_cast<unsigned>(buf.size()), 0);
+            a.sqe.msg_flags = static_cast<std::uint32_t>(flags);
+            return a;
+        }
+
+        io_awaitable send(int fd, std::span<const std::byte> buf, int flags = MSG_NOSIGNAL) {
+            auto a = prep(IORING_OP_SEND, fd, buf.data(), static_cast<unsigned>(buf.size()), 0);
+            a.sqe.msg_flags = static_cast<std::uint32_t>(flags);
+            return a;
+        }
+
+        io_awaitable accept(int fd) {
+            auto a = prep(IORING_OP_ACCEPT, fd, nullptr, 0, 0);
+            a.sqe.accept_flags = SOCK_CLOEXEC;
+            return a;
+        }
+
+        io_awaitable connect(int fd, const sockaddr* addr, socklen_t len) {
+            // for connect the length travels in `off`
+            return prep(IORING_OP_CONNECT, fd, addr, 0, len);
+        }
+
+        io_awaitable close_fd(int fd) { return prep(IORING_OP_CLOSE, fd, nullptr, 0, 0); }
+
+        // metadata operations, which can block for milliseconds on a cold dentry or inode
+        // cache; the kernel runs them on its io workers instead. paths and `out` must stay
+        // valid while the operation is awaited, which a temporary in the `co_await`
+        // expression does
+
+        // resumes with the new fd
+        io_awaitable openat(int dirfd, const char* path, int flags, mode_t mode = 0) {
+            auto a = prep(IORING_OP_OPENAT, dirfd, path, mode, 0);
+            a.sqe.open_flags = static_cast<std::uint32_t>(flags | O_CLOEXEC);
+            return a;
+        }
+
+        io_awaitable statx(int dirfd, const char* path, int flags, unsigned mask, struct statx* out) {
+            auto a = prep(IORING_OP_STATX, dirfd, path, mask, reinterpret_cast<std::uint64_t>(out));
+            a.sqe.statx_flags = static_cast<std::uint32_t>(flags);
+            return a;
+        }
+
+        io_awaitable fallocate(int fd, int mode, std::uint64_t offset, std::uint64_t len) {
+            // the length travels in `addr` and the mode in `len`
+            auto a = prep(IORING_OP_FALLOCATE, fd, nullptr, static_cast<unsigned>(mode), offset);
+            a.sqe.addr = len;
+            return a;
+        }
+
+        io_awaitable renameat(int old_dirfd, const char* old_path, int new_dirfd, const char* new_path,
+                              unsigned flags = 0) {
+            auto a = prep(IORING_OP_RENAMEAT, old_dirfd, old_path, static_cast<unsigned>(new_dirfd),
+                          reinterpret_cast<std::uint64_t>(new_path));
+            a.sqe.rename_flags = flags;
+            return a;
+        }
+
+        // `AT_REMOVEDIR` in `flags` removes a directory
+        io_awaitable unlinkat(int dirfd, const char* path, int flags = 0) {
+            auto a = prep(IORING_OP_UNLINKAT, dirfd, path, 0, 0);
+            a.sqe.unlink_flags = static_cast<std::uint32_t>(flags);
+            return a;
+        }
+
+        io_awaitable mkdirat(int dirfd, const char* path, mode_t mode = 0777) {
+            return prep(IORING_OP_MKDIRAT, dirfd, path, mode, 0);
+        }
+
+        /// one `next()` per accepted connection from a single sqe
+        accept_stream accept_multishot(int fd);
+
+        /// one `next()` per received chunk, each in a buffer picked from `pool` by the kernel
+        recv_stream recv_multishot(int fd, buffer_pool& pool);
+
+    private:
+        struct wake_op_t : io_op {
+            reactor* r = nullptr;
+        };
+
+        executor& ex;
+        detail::uring ring;
+        std::thread thread;
+
+        std::mutex m;
+        work_queue pending;  // of `io_op`s, in submission order
+
+        int wake_fd = -1;
+        std::uint64_t wake_buf = 0;
+        wake_op_t wake_op;
+        std::atomic<bool> sleeping{false};
+        std::atomic<bool> stopping{false};
+        std::atomic<std::size_t> in_flight{0};  // not counting `wake_op`
+        unsigned unsubmitted = 0;  // in the ring, not yet taken by the kernel
+
+        io_awaitable prep(std::uint8_t opcode, int fd, const void* addr, unsigned len, std::uint64_t off) {
+            io_awaitable a{};
+            a.r = this;
+            a.sqe.opcode = opcode;
+            a.sqe.fd = fd;
+            a.sqe.addr = reinterpret_cast<std::uint64_t>(addr);
+            a.sqe.len = len;
+            a.sqe.off = off;
+            return a;
+        }
+
+        // with `m` held
+        void signal() {
+            if (!sleeping.exchange(false, std::memory_order_relaxed)) return;
+            thread_counters::bump(this_thread_counters().io_wakeups);
+            std::uint64_t one = 1;
+            [[maybe_unused]] auto n = ::write(wake_fd, &one, sizeof(one));
+        }
+
+        // everything pending that fits into the ring; a linked chain goes in whole or waits
+        void fill() {
+            std::lock_guard lk{m};
+            unsigned added = 0;
+            unsigned counted = 0;
+            while (!pending.empty()) {
+                unsigned len = 1;
+                for (auto* w = pending.front(); static_cast<io_op*>(w)->sqe.flags & IOSQE_IO_LINK; w = w->next) ++len;
+                if (len > ring.space()) break;
+                for (; len > 0; --len) {
+                    auto* op = static_cast<io_op*>(pending.pop_front());
+                    auto* sqe = ring.next_sqe();
+                    *sqe = op->sqe;
+                    sqe->user_data = reinterpret_cast<std::uint64_t>(op);
+                    ++added;
+                    if (op != &wake_op) ++counted;
+                }
+            }
+            if (added == 0) return;
+            ring.publish();
+            unsubmitted += added;
+            in_flight.fetch_add(counted, std::memory_order_relaxed);
+        }
+
+        bool idle() {
+            std::lock_guard lk{m};
+            return pending.empty();
+        }
+
+        void run() {
+            auto& counters = this_thread_counters();
+            work_queue ready;
+            auto backoff = std::chrono::microseconds{0};
+            while (true) {
+                fill();
+                sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                bool stop = stopping.load(std::memory_order_relaxed);
+                // only wait if nothing was queued after `fill` and nobody is waiting on us to stop
+                bool wait = !stop && idle();
+                if (!wait) sleeping.store(false, std::memory_order_relaxed);
+                int n = detail::io_uring_enter(ring.fd, unsubmitted, wait ? 1 : 0, IORING_ENTER_GETEVENTS);
+                int err = n < 0 ? errno : 0;
+                sleeping.store(false, std::memory_order_relaxed);
+                thread_counters::bump(counters.io_enters);
+                if (n > 0) {
+                    unsubmitted -= static_cast<unsigned>(n);
+                    thread_counters::bump(counters.io_sqes, static_cast<unsigned>(n));
+                }
+                // EINTR, EAGAIN, EBUSY: reaping below makes room, then we try again. anything
+                // else means the ring itself is unusable, and retrying would only spin
+                if (err && err != EINTR && err != EAGAIN && err != EBUSY) {
+                    errno = err;
+                    detail::throw_errno("io_uring_enter");
+                }
+
+                auto reaped = ring.reap([&](const io_uring_cqe& c) {
+                    auto* op = reinterpret_cast<io_op*>(c.user_data);
+                    if (!(c.flags & IORING_CQE_F_MORE) && op != &wake_op) in_flight.fetch_sub(1, std::memory_order_relaxed);
+                    op->complete(op, c.res, c.flags, ready);
+                });
+                thread_counters::bump(counters.io_cqes, reaped);
+                ex.schedule(ready);
+                if (stop && idle()) return;
+                // out of kernel memory, or an overflowed completion queue, with nothing
+                // completing: back off instead of hammering the kernel
+                if ((err == EAGAIN || err == EBUSY) && reaped == 0) {
+                    backoff = std::clamp(backoff * 2, std::chrono::microseconds{10}, std::chrono::microseconds{1000});
+                    std::this_thread::sleep_for(backoff);
+                } else {
+                    backoff = {};
+                }
+            }
+        }
+
+        friend struct buffer_pool;
+    };
+
+    template<class P>
+    bool io_awaitable::await_suspend(std::coroutine_handle<P> h) {
+        handle = h;
+        complete = [](io_op* self, int res, std::uint32_t, work_queue& ready) {
+            auto* a = static_cast<io_awaitable*>(self);
+            a->res = res;
+            if (a->cancel.set(detail::cancel_state::done)) ready.push_back(a);
+        };
+        if constexpr (requires { h.promise().stop; }) {
+            auto& stop = h.promise().stop;
+            if (stop.stop_requested()) {
+                res = -ECANCELED;
+                cancel.cancel_unsubmitted();
+                return false;
+            }
+            r->submit(this);
+            // may run `request_cancel` right here if a stop comes in meanwhile
+            if (stop.stop_possible()) cancel.on_stop.emplace(stop, detail::cancel_fn{this, request_cancel});
+        } else {
+            r->submit(this);
+        }
+        // it may have completed already: then carry on without suspending. otherwise
+        // `this` is off limits from here
+        return !cancel.set(detail::cancel_state::suspended);
+    }
+
+    inline void io_awaitable::request_cancel(void* p) noexcept {
+        auto* self = static_cast<io_awaitable*>(p);
+        if (!self->cancel.begin_cancel(1)) return;
+        self->cancel_sqe.prepare(self, self->cancel, self);
+        self->r->submit(&self->cancel_sqe);
+    }
+
+    namespace detail {
+        struct link_state : work_item {
+            std::size_t remaining = 0;
+        };
+    }
+
+    /// `co_await co::link(a, b, ...)` submits the ops as an io_uring chain: each starts
+    /// only after the one before succeeded, and once one fails the rest complete with
+    /// `-ECANCELED`. resumes when all of them have completed, with every `res` in order.
+    /// a stop request cancels every sqe of the chain, and throws `operation_cancelled` if
+    /// that cut it short
+    template<std::size_t N>
+    struct link_awaitable : detail::link_state {
+        struct step : io_op {
+            link_awaitable* parent = nullptr;
+            std::size_t index = 0;
+        };
+
+        reactor* r;
+        std::array<step, N> steps{};
+        std::array<int, N> results{};
+        detail::cancel_state cancel;
+        std::array<detail::cancel_op, N> cancel_sqes{};
+
+        bool await_ready() noexcept { return false; }
+
+        template<class P>
+        bool await_suspend(std::coroutine_handle<P> h) {
+            handle = h;
+            if constexpr (requires { h.promise().stop; }) {
+                if (h.promise().stop.stop_requested()) {
+                    results.fill(-ECANCELED);
+                    cancel.cancel_unsubmitted();
+                    return false;
+                }
+            }
+            remaining = N;
+            std::array<io_op*, N> ops;
+            for (std::size_t i = 0; i < N; ++i) {
+                auto& s = steps[i];
+                s.parent = this;
+                s.index = i;
+                s.complete = [](io_op* self, int res, std::uint32_t, work_queue& ready) {
+                    auto* s = static_cast<step*>(self);
+                    auto* parent = s->parent;
+                    parent->results[s->index] = res;
+                    // the reactor thread is the only one counting down
+                    if (--parent->remaining == 0 && parent->cancel.set(detail::cancel_state::done)) {
+                        ready.push_back(parent);
+                    }
+                };
+                if (i + 1 < N) s.sqe.flags |= IOSQE_IO_LINK;
+                ops[i] = &s;
+            }
+            r->submit(ops.data(), N);
+            if constexpr (requires { h.promise().stop; }) {
+                if (h.promise().stop.stop_possible()) {
+                    cancel.on_stop.emplace(h.promise().stop, detail::cancel_fn{this, request_cancel});
+                }
+            }
+            return !cancel.set(detail::cancel_state::suspended);
+        }
+
+        std::array<int, N> await_resume() {
+            cancel.on_stop.reset();
+            if (cancel.cancelled() && std::ranges::any_of(results, detail::cancelled_res)) throw operation_cancelled{};
+            return results;
+        }
+
+    private:
+        // the running step fails with `-ECANCELED`, and takes the rest of the chain with
+        // it; a cancel for a step that is done already finds nothing
+        static void request_cancel(void* p) noexcept {
+            auto* self = static_cast<link_awaitable*>(p);
+            if (!self->cancel.begin_cancel(N)) return;
+            std::array<io_op*, N> ops;
+            for (std::size_t i = 0; i < N; ++i) {
+                self->cancel_sqes[i].prepare(self, self->cancel, &self->steps[i]);
+                ops[i] = &self->cancel_sqes[i];
+            }
+            self->r->submit(ops.data(), N);
+        }
+    };
+
+    template<class... Ops>
+        requires(sizeof...(Ops) > 0 && (std::is_same_v<Ops, io_awaitable> && ...))
+    link_awaitable<sizeof...(Ops)> link(Ops... ops) {
+        link_awaitable<sizeof...(Ops)> l{};
+        l.r = std::get<0>(std::tie(ops...)).r;
+        std::size_t i = 0;
+        ((l.steps[i++].sqe = ops.sqe), ...);
+        return l;
+    }
+
+    /// a provided buffer ring (`IORING_REGISTER_PBUF_RING`, Linux 5.19): `count` buffers
+    /// of `size` bytes the kernel picks from for multishot receives, each handed back
+    /// when the `received` chunk that holds it is destroyed
+    struct buffer_pool {
+        /// at most 32768 buffers, the largest ring the kernel registers
+        buffer_pool(reactor& r, std::uint16_t group, std::uint16_t count, std::size_t size)
+                : r(r), group(group), size(size) {
+            if (count == 0 || count > 32768) throw std::invalid_argument("co::buffer_pool: count must be 1..32768");
+            entries = 1;
+            while (entries < count) entries <<= 1;
+            ring_bytes = entries * sizeof(io_uring_buf);
+            void* p = mmap(nullptr, ring_bytes, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+            if (p == MAP_FAILED) detail::throw_errno("buffer ring mmap");
+            bufs = static_cast<io_uring_buf_ring*>(p);
+            storage = std::make_unique<std::byte[]>(entries * size);
+
+            io_uring_buf_reg reg{};
+            reg.ring_addr = reinterpret_cast<std::uint64_t>(bufs);
+            reg.ring_entries = entries;
+            reg.bgid = group;
+            if (detail::io_uring_register(r.ring_fd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+                munmap(bufs, ring_bytes);
+                detail::throw_errno("IORING_REGISTER_PBUF_RING");
+            }
+            for (std::uint32_t bid = 0; bid < entries; ++bid) add(static_cast<std::uint16_t>(bid));
+            detail::store_release(&bufs->tail, tail);
+        }
+
+        ~buffer_pool() {
+            io_uring_buf_reg reg{};
+            reg.bgid = group;
+            detail::io_uring_register(r.ring_fd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+            munmap(bufs, ring_bytes);
+        }
+
+        buffer_pool(const buffer_pool&) = delete;
+
+        buffer_pool& operator=(const buffer_pool&) = delete;
+
+        std::uint16_t id() const noexcept { return group; }
+
+        std::span<const std::byte> data(std::uint16_t bid, std::size_t n) const noexcept {
+            return {storage.get() + bid * size, n};
+        }
+
+        // from any thread
+        void give_back(std::uint16_t bid) {
+            std::lock_guard lk{m};
+            add(bid);
+            detail::store_release(&bufs->tail, tail);
+        }
+
+    private:
+        reactor& r;
+        std::uint16_t group;
+        std::size_t size;
+        unsigned entries = 0;
+        std::size_t ring_bytes = 0;
+        io_uring_buf_ring* bufs = nullptr;
+        std::unique_ptr<std::byte[]> storage;
+        std::mutex m;
+        std::uint16_t tail = 0;
+
+        void add(std::uint16_t bid) {
+            // not `bufs->bufs`: the header's flexible array member lands at offset 8 in C++
+            auto& b = reinterpret_cast<io_uring_buf*>(bufs)[tail & (entries - 1)];
+            b.addr = reinterpret_cast<std::uint64_t>(storage.get() + bid * size);
+            b.len = static_cast<std::uint32_t>(size);
+            b.bid = bid;
+            ++tail;
+        }
+    };
+
+    /// one chunk from `recv_stream`; its buffer goes back to the pool with it
+    struct received {
+        std::span<const std::byte> data;
+        buffer_pool* pool = nullptr;
+        std::uint16_t bid = 0;
+
+        received(std::span<const std::byte> data, buffer_pool* pool, std::uint16_t bid)
+                : data(data), pool(pool), bid(bid) {}
+
+        received(received&& other) noexcept
+                : data(other.data), pool(std::exchange(other.pool, nullptr)), bid(other.bid) {}
+
+        received& operator=(received&&) = delete;
+
+        ~received() {
+            if (pool) pool->give_back(bid);
+        }
+    };
+
+    namespace detail {
+        /// a multishot sqe and the completions it produced that nobody has taken yet
+        /// one consumer at a time calls `next()`
+        struct multishot : io_op {
+            struct cqe {
+                int res;
+                std::uint32_t flags;
+            };
+
+            reactor* r = nullptr;
+            std::mutex m;
+            std::deque<cqe> ready;
+            work_item* waiter = nullptr;
+            bool started = false;
+            bool done = false;
+            bool zero_ends = false;  // recv: 0 is end of stream, accept: 0 is an fd
+            int err = 0;
+            io_op cancel_op;
+            std::atomic<bool> cancel_sent{false};  // `cancel_op` is intrusive: queued once at most
+
+            explicit multishot(reactor& r) : r(&r) {
+                complete = on_cqe;
+                cancel_op.complete = [](io_op*, int, std::uint32_t, work_queue&) {};
+            }
+
+            multishot(multishot&& other) noexcept : io_op(other), r(other.r), zero_ends(other.zero_ends) {
+                cancel_op.complete = other.cancel_op.complete;
+            }
+
+            static void on_cqe(io_op* self, int res, std::uint32_t flags, work_queue& q) {
+                auto* s = static_cast<multishot*>(self);
+                work_item* w;
+                {
+                    std::lock_guard lk{s->m};
+                    if (res > 0 || (res == 0 && !s->zero_ends)) {
+                        s->ready.push_back({res, flags});
+                    } else if (res < 0) {
+                        s->err = res;
+                    }
+                    if (!(flags & IORING_CQE_F_MORE)) s->done = true;
+                    w = std::exchange(s->waiter, nullptr);
+                }
+                if (w) q.push_back(w);
+            }
+
+            struct next_awaitable : work_item {
+                multishot& s;
+                std::optional<cqe> got;
+
+                bool await_ready() {
+                    if (!s.started) {
+                        s.started = true;
+                        s.r->submit(&s);
+                    }
+                    return take();
+                }
+
+                bool await_suspend(std::coroutine_handle<> h) {
+                    handle = h;
+                    std::lock_guard lk{s.m};
+                    if (!s.ready.empty() || s.done) return false;
+                    s.waiter = this;
+                    return true;
+                }
+
+                void await_resume() { take(); }
+
+                bool take() {
+                    std::lock_guard lk{s.m};
+                    if (got) return true;
+                    if (!s.ready.empty()) {
+                        got = s.ready.front();
+                        s.ready.pop_front();
+                        return true;
+                    }
+                    return s.done;
+                }
+            };
+
+            void cancel() {
+                if (cancel_sent.exchange(true, std::memory_order_acq_rel)) return;
+                cancel_op.sqe.opcode = IORING_OP_ASYNC_CANCEL;
+                cancel_op.sqe.fd = -1;
+                cancel_op.sqe.addr = reinterpret_cast<std::uint64_t>(static_cast<io_op*>(this));
+                r->submit(&cancel_op);
+            }
+        };
+    }
+
+    /// `while (auto fd = co_await conns.next())`: nullopt once the kernel ends the stream,
+    /// after `cancel()` or an error, which `error()` then returns as `-errno`
+    /// the stream must not be moved once `next()` was awaited, nor destroyed before it ended
+    struct accept_stream {
+        explicit accept_stream(detail::multishot op) : op(std::move(op)) {}
+
+        auto next() {
+            struct awaitable : detail::multishot::next_awaitable {
+                std::optional<int> await_resume() {
+                    take();
+                    return got ? std::optional<int>{got->res} : std::nullopt;
+                }
+            };
+            return awaitable{{{}, op, {}}};
+        }
+
+        void cancel() { op.cancel(); }
+
+        int error() {
+            std::lock_guard lk{op.m};
+            return op.err;
+        }
+
+    private:
+        detail::multishot op;
+    };
+
+    /// `while (auto chunk = co_await in.next())` until end of stream (`error() == 0`),
+    /// an error, or `-ENOBUFS` when every buffer of the pool is still held
+    struct recv_stream {
+        recv_stream(detail::multishot op, buffer_pool& pool) : op(std::move(op)), pool(&pool) {}
+
+        auto next() {
+            struct awaitable : detail::multishot::next_awaitable {
+                buffer_pool* pool;
+
+                std::optional<received> await_resume() {
+                    take();
+                    if (!got) return std::nullopt;
+                    auto bid = static_cast<std::uint16_t>(got->flags >> IORING_CQE_BUFFER_SHIFT);
+                    return received{pool->data(bid, static_cast<std::size_t>(got->res)), pool, bid};
+                }
+            };
+            return awaitable{{{}, op, {}}, pool};
+        }
+
+        void cancel() { op.cancel(); }
+
+        int error() {
+            std::lock_guard lk{op.m};
+            return op.err;
+        }
+
+    private:
+        detail::multishot op;
+        buffer_pool* pool;
+    };
+
+    inline accept_stream reactor::accept_multishot(int fd) {
+        detail::multishot op{*this};
+        op.sqe.opcode = IORING_OP_ACCEPT;
+        op.sqe.fd = fd;
+        op.sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+        op.sqe.accept_flags = SOCK_CLOEXEC;
+        return accept_stream{std::move(op)};
+    }
+
+    inline recv_stream reactor::recv_multishot(int fd, buffer_pool& pool) {
+        detail::multishot op{*this};
+        op.sqe.opcode = IORING_OP_RECV;
+        op.sqe.fd = fd;
+        op.sqe.ioprio = IORING_RECV_MULTISHOT;
+        op.sqe.flags = IOSQE_BUFFER_SELECT;
+        op.sqe.buf_group = pool.id();
+        op.zero_ends = true;
+        return recv_stream{std::move(op), pool};
+    }
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "executor.hpp"
+
+namespace co {
+    struct async_shared_mutex;
+
+    /// returned by `co_await m.lock_shared()`; releases the read lock on destruction
+    struct shared_lock_guard {
+        async_shared_mutex* m;
+        std::atomic<std::int64_t>* slot;  // nullptr: taken on the slow path
+
+        shared_lock_guard(async_shared_mutex& m, std::atomic<std::int64_t>* slot) : m(&m), slot(slot) {}
+
+        shared_lock_guard(shared_lock_guard&& other) noexcept
+                : m(std::exchange(other.m, nullptr)), slot(other.slot) {}
+
+        shared_lock_guard& operator=(shared_lock_guard&&) = delete;
+
+        ~shared_lock_guard();
+    };
+
+    /// reader-writer lock biased towards readers (BRAVO, Dice & Kogan 2019)
+    ///
+    /// while `reader_bias` is set a reader only increments the counter of the core it runs
+    /// on and re-checks the bias: no shared cache line is written. a writer clears the bias,
+    /// then suspends until every per-core counter has drained; the reader that brings the
+    /// last counter to zero resumes it. readers arriving meanwhile take the slow path, a
+    /// FIFO queue behind the writer. the bias comes back once enough time has passed to
+    /// amortize the revocation (9x what it cost): the first reader or unlocking writer to
+    /// find the lock free after that restores it
+    struct async_shared_mutex {
+        using clock = std::chrono::steady_clock;
+
+        explicit async_shared_mutex(std::size_t n_slots = std::thread::hardware_concurrency())
+                : n_slots(n_slots ? n_slots : 1), slots(std::make_unique<slot_t[]>(this->n_slots)) {}
+
+        async_shared_mutex(const async_shared_mutex&) = delete;
+
+        async_shared_mutex& operator=(const async_shared_mutex&) = delete;
+
+        struct waiter : work_item {
+            async_shared_mutex& mtx;
+            bool exclusive;
+
+            waiter(async_shared_mutex& mtx, bool exclusive) : mtx(mtx), exclusive(exclusive) {}
+        };
+
+        struct lock_shared_awaitable : waiter {
+            std::atomic<std::int64_t>* slot = nullptr;
+
+            explicit lock_shared_awaitable(async_shared_mutex& mtx) : waiter(mtx, false) {}
+
+            bool await_ready() noexcept {
+                slot = mtx.try_lock_shared_fast();
+                count_fast_path(fast_path::shared_mutex_read, slot != nullptr);
+                return slot != nullptr;
+            }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return mtx.lock_shared_slow(this);
+            }
+
+            shared_lock_guard await_resume() noexcept { return {mtx, slot}; }
+        };
+
+        struct lock_awaitable : waiter {
+            explicit lock_awaitable(async_shared_mutex& mtx) : waiter(mtx, true) {}
+
+            bool await_ready() noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return mtx.lock_slow(this);
+            }
+
+            void await_resume() noexcept { mtx.on_locked(); }
+        };
+
+        // `auto guard = co_await m.lock_shared();`
+        lock_shared_awaitable lock_shared() { return lock_shared_awaitable{*this}; }
+
+        lock_awaitable lock() { return lock_awaitable{*this}; }
+
+        void unlock() {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                writer = false;
+                if (waiters.empty()) restore_bias_locked();
+                grant_locked(ready);
+            }
+            wake(ready);
+        }
+
+    private:
+        friend struct shared_lock_guard;
+
+        struct alignas(64) slot_t {
+            std::atomic<std::int64_t> readers{0};
+        };
+
+        const std::size_t n_slots;
+        std::unique_ptr<slot_t[]> slots;
+        std::atomic<bool> reader_bias{true};
+        std::atomic<work_item*> drain_waiter{nullptr};
+
+        std::mutex m;
+        bool writer = false;
+        std::size_t slow_readers = 0;
+        work_queue waiters;
+
+        // only touched by the writer holding the lock
+        bool revoked = false;
+        clock::time_point revoke_start{};
+        // set by that writer, read by slow-path readers; a `clock::rep`
+        std::atomic<clock::rep> inhibit_until{0};
+
+        std::atomic<std::int64_t>* try_lock_shared_fast() noexcept {
+            if (!reader_bias.load(std::memory_order_relaxed)) return nullptr;
+            auto cpu = sched_getcpu();
+            auto* slot = &slots[static_cast<std::size_t>(cpu < 0 ? 0 : cpu) % n_slots].readers;
+            slot->fetch_add(1, std::memory_order_seq_cst);
+            // a writer may have revoked the bias between the check and the increment
+            if (reader_bias.load(std::memory_order_seq_cst)) return slot;
+            unlock_shared_fast(slot);
+            return nullptr;
+        }
+
+        bool fast_readers_drained() const noexcept {
+            for (std::size_t i = 0; i < n_slots; ++i) {
+                if (slots[i].readers.load(std::memory_order_seq_cst) != 0) return false;
+            }
+            return true;
+        }
+
+        void unlock_shared_fast(std::atomic<std::int64_t>* slot) {
+            slot->fetch_sub(1, std::memory_order_seq_cst);
+            if (reader_bias.load(std::memory_order_seq_cst) || !fast_readers_drained()) return;
+            // several readers may see the counters drain; exactly one gets the writer
+            if (auto* w = drain_waiter.exchange(nullptr, std::memory_order_acq_rel)) wake(w);
+        }
+
+        // the writer flag is ours; wait for biased readers to leave
+        // true: they already have, `w` may run now
+        bool drain(work_item* w) {
+            revoked = reader_bias.exchange(false, std::memory_order_seq_cst);
+            if (revoked) revoke_start = clock::now();
+            drain_waiter.store(w, std::memory_order_seq_cst);
+            // otherwise the last reader out schedules `w`
+            return fast_readers_drained() && drain_waiter.exchange(nullptr, std::memory_order_acq_rel) == w;
+        }
+
+        // runs in the writer once it owns the lock
+        void on_locked() {
+            if (revoked) {
+                auto now = clock::now();
+                inhibit_until.store((now + 9 * (now - revoke_start)).time_since_epoch().count(),
+                                    std::memory_order_relaxed);
+            }
+        }
+
+        // under `m` with no writer holding or waiting: a writer sets its flag under `m`
+        // before it revokes, so the bias can't come back under its feet
+        void restore_bias_locked() {
+            if (reader_bias.load(std::memory_order_relaxed)) return;
+            if (clock::now().time_since_epoch().count() < inhibit_until.load(std::memory_order_relaxed)) return;
+            reader_bias.store(true, std::memory_order_seq_cst);
+        }
+
+        // the next reader takes the fast path again once the bias is restored here
+        bool lock_shared_slow(lock_shared_awaitable* w) {
+            std::lock_guard lk{m};
+            if (!writer && waiters.empty()) {
+                restore_bias_locked();
+                ++slow_readers;
+                return false;
+            }
+            waiters.push_back(w);
+            return true;
+        }
+
+        bool lock_slow(lock_awaitable* w) {
+            {
+                std::lock_guard lk{m};
+                if (writer || slow_readers > 0 || !waiters.empty()) {
+                    waiters.push_back(w);
+                    return true;
+                }
+                writer = true;
+            }
+            return !drain(w);
+        }
+
+        void unlock_shared_slow() {
+            work_queue ready;
+            {
+                std::lock_guard lk{m};
+                if (--slow_readers == 0) grant_locked(ready);
+            }
+            wake(ready);
+        }
+
+        // FIFO hand-off once the lock is free: either one writer or every reader up to the
+        // next writer. a granted writer still has to drain before it runs
+        void grant_locked(work_queue& ready) {
+            if (writer || slow_readers > 0) return;
+            while (auto* front = static_cast<waiter*>(waiters.front())) {
+                if (front->exclusive) {
+                    if (slow_readers > 0) break;
+                    writer = true;
+                    waiters.pop_front();
+                    ready.push_back(front);
+                    break;
+                }
+                ++slow_readers;
+                ready.push_back(waiters.pop_front());
+            }
+        }
+
+        void wake(work_queue& ready) {
+            work_queue readers;
+            while (auto* w = ready.pop_front()) {
+                if (!static_cast<waiter*>(w)->exclusive) {
+                    readers.push_back(w);
+                } else if (drain(w)) {
+                    wake(w);
+                }
+            }
+            if (readers.empty()) return;
+            if (auto* ex = executor::current()) {
+                ex->schedule(readers);
+                return;
+            }
+            while (auto* w = readers.pop_front()) w->handle.resume();
+        }
+
+        static void wake(work_item* w) {
+            if (auto* ex = executor::current()) {
+                ex->schedule(w);
+            } else {
+                w->handle.resume();
+            }
+        }
+    };
+
+    inline shared_lock_guard::~shared_lock_guard() {
+        if (!m) return;
+        if (slot) {
+            m->unlock_shared_fast(slot);
+        } else {
+            m->unlock_shared_slow();
+        }
+    }
+}
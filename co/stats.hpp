@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+
+namespace co {
+    /// awaitables with an uncontended path report whether they took it
+    enum class fast_path : std::size_t {
+        rate_limiter,
+        mutex,
+        shared_mutex_read,
+        count
+    };
+
+    inline const char* name(fast_path p) {
+        switch (p) {
+            case fast_path::rate_limiter: return "rate_limiter";
+            case fast_path::mutex: return "mutex";
+            case fast_path::shared_mutex_read: return "shared_mutex_read";
+            default: return "?";
+        }
+    }
+
+    /// one per thread; only its own thread writes it, readers sum over all of them, so
+    /// counting never bounces a shared cache line
+    struct alignas(64) thread_counters {
+        std::atomic<std::uint64_t> frames_created{0};
+        std::atomic<std::uint64_t> frames_destroyed{0};
+        std::atomic<std::uint64_t> frame_bytes_allocated{0};
+        std::atomic<std::uint64_t> frame_bytes_freed{0};
+        std::atomic<std::uint64_t> resumes{0};
+        std::atomic<std::uint64_t> inline_resumes{0};
+        std::atomic<std::uint64_t> steals{0};
+        std::atomic<std::uint64_t> parks{0};
+        std::atomic<std::uint64_t> timer_wakeups{0};
+        std::atomic<std::uint64_t> timers_fired{0};
+        std::atomic<std::uint64_t> io_enters{0};
+        std::atomic<std::uint64_t> io_sqes{0};
+        std::atomic<std::uint64_t> io_cqes{0};
+        std::atomic<std::uint64_t> io_wakeups{0};
+        std::array<std::atomic<std::uint64_t>, std::size_t(fast_path::count)> fast_hits{};
+        std::array<std::atomic<std::uint64_t>, std::size_t(fast_path::count)> fast_misses{};
+
+        bool in_use = false;  // guarded by the registry lock
+
+        // single writer: a plain load + store, no locked instruction
+        static void bump(std::atomic<std::uint64_t>& c, std::uint64_t n = 1) noexcept {
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    };
+
+    namespace detail {
+        /// every thread's counters. slots are recycled when a thread exits, so totals
+        /// survive the thread and the list stays as long as the peak thread count
+        struct counter_registry {
+            std::mutex m;
+            std::vector<std::unique_ptr<thread_counters>> all;
+
+            thread_counters* acquire() {
+                std::lock_guard lk{m};
+                for (auto& c: all) {
+                    if (!c->in_use) {
+                        c->in_use = true;
+                        return c.get();
+                    }
+                }
+                all.push_back(std::make_unique<thread_counters>());
+                all.back()->in_use = true;
+                return all.back().get();
+            }
+
+            void release(thread_counters* c) {
+                std::lock_guard lk{m};
+                c->in_use = false;
+            }
+
+            template<class F>
+            void for_each(F f) {
+                std::lock_guard lk{m};
+                for (auto& c: all) f(*c);
+            }
+        };
+
+        // leaked on purpose: thread_local destructors may run after static destruction
+        inline counter_registry& registry() {
+            static auto* r = new counter_registry;
+            return *r;
+        }
+
+        struct counters_slot {
+            thread_counters* c = registry().acquire();
+
+            ~counters_slot() { registry().release(c); }
+        };
+    }
+
+    inline thread_counters& this_thread_counters() {
+        thread_local detail::counters_slot slot;
+        return *slot.c;
+    }
+
+    inline void count_fast_path(fast_path p, bool hit) noexcept {
+        auto& c = this_thread_counters();
+        thread_counters::bump(hit ? c.fast_hits[std::size_t(p)] : c.fast_misses[std::size_t(p)]);
+    }
+
+    namespace detail {
+        /// mixed into promise types: counts frames and frame bytes
+        struct counted_frame {
+            static void* operator new(std::size_t n) {
+                void* p = ::operator new(n);
+                auto& c = this_thread_counters();
+                thread_counters::bump(c.frames_created);
+                thread_counters::bump(c.frame_bytes_allocated, n);
+                return p;
+            }
+
+            // inlined like `operator new`, so GCC pairs the global sized delete with the
+            // global new instead of reporting a mismatch on the coroutine's cleanup path
+            [[gnu::always_inline]] static void operator delete(void* p, std::size_t n) noexcept {
+                auto& c = this_thread_counters();
+                thread_counters::bump(c.frames_destroyed);
+                thread_counters::bump(c.frame_bytes_freed, n);
+                ::operator delete(p, n);
+            }
+        };
+    }
+
+    /// a point-in-time sum over every thread's counters, plus whatever gauges the
+    /// components that were passed to `collect` expose
+    struct runtime_stats {
+        std::chrono::steady_clock::time_point taken_at{};
+        std::uint64_t frames_created = 0;
+        std::uint64_t frames_destroyed = 0;
+        std::uint64_t frame_bytes_allocated = 0;
+        std::uint64_t frame_bytes_freed = 0;
+        std::uint64_t resumes = 0;
+        std::uint64_t inline_resumes = 0;
+        std::uint64_t steals = 0;
+        std::uint64_t parks = 0;
+        std::uint64_t timer_wakeups = 0;
+        std::uint64_t timers_fired = 0;
+        std::uint64_t io_enters = 0;
+        std::uint64_t io_sqes = 0;
+        std::uint64_t io_cqes = 0;
+        std::uint64_t io_wakeups = 0;
+        std::array<std::uint64_t, std::size_t(fast_path::count)> fast_hits{};
+        std::array<std::uint64_t, std::size_t(fast_path::count)> fast_misses{};
+
+        std::vector<std::size_t> worker_queue_depths;
+        std::size_t global_queue_depth = 0;
+        std::size_t timers = 0;
+        std::size_t io_in_flight = 0;
+
+        std::uint64_t live_frames() const { return frames_created - frames_destroyed; }
+
+        std::uint64_t live_frame_bytes() const { return frame_bytes_allocated - frame_bytes_freed; }
+
+        double fast_path_hit_rate(fast_path p) const {
+            auto hits = fast_hits[std::size_t(p)];
+            auto total = hits + fast_misses[std::size_t(p)];
+            return total ? double(hits) / double(total) : 0.0;
+        }
+
+        // resumes per second between an earlier snapshot and this one
+        double resume_rate(const runtime_stats& earlier) const {
+            auto s = std::chrono::duration<double>(taken_at - earlier.taken_at).count();
+            return s > 0 ? double(resumes - earlier.resumes) / s : 0.0;
+        }
+
+        static runtime_stats collect() {
+            runtime_stats s;
+            s.taken_at = std::chrono::steady_clock::now();
+            detail::registry().for_each([&](thread_counters& c) {
+                auto get = [](const std::atomic<std::uint64_t>& v) { return v.load(std::memory_order_relaxed); };
+                s.frames_created += get(c.frames_created);
+                s.frames_destroyed += get(c.frames_destroyed);
+                s.frame_bytes_allocated += get(c.frame_bytes_allocated);
+                s.frame_bytes_freed += get(c.frame_bytes_freed);
+                s.resumes += get(c.resumes);
+                s.inline_resumes += get(c.inline_resumes);
+                s.steals += get(c.steals);
+                s.parks += get(c.parks);
+                s.timer_wakeups += get(c.timer_wakeups);
+                s.timers_fired += get(c.timers_fired);
+                s.io_enters += get(c.io_enters);
+                s.io_sqes += get(c.io_sqes);
+                s.io_cqes += get(c.io_cqes);
+                s.io_wakeups += get(c.io_wakeups);
+                for (std::size_t i = 0; i < s.fast_hits.size(); ++i) {
+                    s.fast_hits[i] += get(c.fast_hits[i]);
+                    s.fast_misses[i] += get(c.fast_misses[i]);
+                }
+            });
+            return s;
+        }
+    };
+
+    /// Prometheus-style text; with `earlier`, rates are included too
+    inline void write_text(std::ostream& os, const runtime_stats& s, const runtime_stats* earlier = nullptr) {
+        os << "co_live_frames " << s.live_frames() << "\n";
+        os << "co_live_frame_bytes " << s.live_frame_bytes() << "\n";
+        os << "co_frames_created_total " << s.frames_created << "\n";
+        os << "co_resumes_total " << s.resumes << "\n";
+        if (earlier) os << "co_resumes_per_second " << s.resume_rate(*earlier) << "\n";
+        os << "co_inline_resumes_total " << s.inline_resumes << "\n";
+        os << "co_steals_total " << s.steals << "\n";
+        os << "co_parks_total " << s.parks << "\n";
+        os << "co_global_queue_depth " << s.global_queue_depth << "\n";
+        for (std::size_t i = 0; i < s.worker_queue_depths.size(); ++i) {
+            os << "co_worker_queue_depth{worker=\"" << i << "\"} " << s.worker_queue_depths[i] << "\n";
+        }
+        os << "co_timers " << s.timers << "\n";
+        os << "co_timer_wakeups_total " << s.timer_wakeups << "\n";
+        os << "co_timers_fired_total " << s.timers_fired << "\n";
+        os << "co_io_enters_total " << s.io_enters << "\n";
+        os << "co_io_sqes_total " << s.io_sqes << "\n";
+        os << "co_io_cqes_total " << s.io_cqes << "\n";
+        os << "co_io_wakeups_total " << s.io_wakeups << "\n";
+        os << "co_io_in_flight " << s.io_in_flight << "\n";
+        for (std::size_t i = 0; i < std::size_t(fast_path::count); ++i) {
+            auto p = fast_path(i);
+            os << "co_fast_path_hits_total{path=\"" << name(p) << "\"} " << s.fast_hits[i] << "\n";
+            os << "co_fast_path_misses_total{path=\"" << name(p) << "\"} " << s.fast_misses[i] << "\n";
+        }
+    }
+}
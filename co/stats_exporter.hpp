@@ -0,0 +1,35 @@
+#pragma once
+
+#include <concepts>
+#include <cstdio>
+#include <fstream>
+#include <stop_token>
+#include <string>
+
+#include "executor.hpp"
+#include "stats.hpp"
+
+namespace co {
+    /// rewrites `path` with `write_text(source.stats())` every `period` until `stop` is
+    /// requested. `source` is an `executor`, or a `reactor`, whose stats add the I/O still
+    /// in flight (`co_io_in_flight`, always 0 from an executor alone)
+    /// written to `path.tmp` and renamed over, so a reader never sees half a file
+    template<class Source>
+        requires requires(Source& s) {
+            { s.stats() } -> std::same_as<runtime_stats>;
+        }
+    task<> export_stats(Source& source, std::string path, timer_wheel::clock::duration period, std::stop_token stop) {
+        auto earlier = source.stats();
+        while (!stop.stop_requested()) {
+            co_await sleep_for(period);
+            auto now = source.stats();
+            auto tmp = path + ".tmp";
+            {
+                std::ofstream f{tmp, std::ios::trunc};
+                write_text(f, now, &earlier);
+            }
+            std::rename(tmp.c_str(), path.c_str());
+            earlier = std::move(now);
+        }
+    }
+}
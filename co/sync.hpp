@@ -0,0 +1,376 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+#include "executor.hpp"
+
+namespace co {
+    /// waiters never block a worker: they park their own frame on an intrusive list and the
+    /// whole list goes back to the executor with one `schedule`
+    ///
+    /// `unlock`, `count_down`, `notify_*` and `arrive_and_drop` only ever schedule whoever
+    /// they wake, so they return before any woken code runs, and may be called under a
+    /// lock the woken task also takes. only a coroutine that is itself suspending at the
+    /// time (`cv.wait`, `arrive_and_wait`) hands off inline: to the next mutex owner by
+    /// symmetric transfer, or to a lone latch / barrier waiter via `executor::dispatch`
+    ///
+    /// where a short internal `std::mutex` is used it only guards a list, never user code
+
+    struct async_mutex;
+
+    /// unlocks on destruction
+    struct async_lock_guard {
+        async_mutex* m;
+
+        explicit async_lock_guard(async_mutex& m) : m(&m) {}
+
+        async_lock_guard(async_lock_guard&& other) noexcept : m(std::exchange(other.m, nullptr)) {}
+
+        async_lock_guard& operator=(async_lock_guard&&) = delete;
+
+        ~async_lock_guard();
+    };
+
+    /// FIFO mutex; `unlock` hands ownership straight to the next waiter
+    struct async_mutex {
+        async_mutex() = default;
+
+        async_mutex(const async_mutex&) = delete;
+
+        async_mutex& operator=(const async_mutex&) = delete;
+
+        struct lock_awaitable : work_item {
+            async_mutex& mtx;
+
+            explicit lock_awaitable(async_mutex& mtx) : mtx(mtx) {}
+
+            bool await_ready() noexcept {
+                bool hit = mtx.try_lock();
+                count_fast_path(fast_path::mutex, hit);
+                return hit;
+            }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                std::lock_guard lk{mtx.m};
+                if (!mtx.locked) {
+                    mtx.locked = true;
+                    return false;
+                }
+                mtx.waiters.push_back(this);
+                return true;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        struct scoped_lock_awaitable : lock_awaitable {
+            using lock_awaitable::lock_awaitable;
+
+            async_lock_guard await_resume() noexcept { return async_lock_guard{mtx}; }
+        };
+
+        lock_awaitable lock() { return lock_awaitable{*this}; }
+
+        // `auto guard = co_await m.scoped_lock();`
+        scoped_lock_awaitable scoped_lock() { return scoped_lock_awaitable{*this}; }
+
+        bool try_lock() {
+            std::lock_guard lk{m};
+            return !std::exchange(locked, true);
+        }
+
+        // the next owner is scheduled, not run here
+        void unlock() {
+            if (auto* next = release()) resume_on(next);
+        }
+
+    private:
+        friend struct async_condition_variable;
+
+        std::mutex m;
+        bool locked = false;
+        work_queue waiters;
+
+        // the next waiter, which owns the lock now; nullptr: it's free
+        work_item* release() {
+            std::lock_guard lk{m};
+            auto* next = waiters.pop_front();
+            if (!next) locked = false;
+            return next;
+        }
+
+        static void resume_on(work_item* w) {
+            if (auto* ex = executor::current()) {
+                ex->schedule(w);
+            } else {
+                w->handle.resume();
+            }
+        }
+
+        // condition variable waiters re-acquire here without being woken in between
+        void requeue(work_queue& q) {
+            if (q.empty()) return;
+            work_item* next = nullptr;
+            {
+                std::lock_guard lk{m};
+                waiters.splice_back(q);
+                if (!locked) {
+                    locked = true;
+                    next = waiters.pop_front();
+                }
+            }
+            if (next) resume_on(next);
+        }
+    };
+
+    inline async_lock_guard::~async_lock_guard() {
+        if (m) m->unlock();
+    }
+
+    /// `co_await cv.wait(mtx)` must be called with `mtx` held, and returns with it held again
+    ///
+    /// notified waiters are moved onto the mutex's own waiter list instead of the ready
+    /// queue ("wait morphing"): `notify_all` splices the whole list in O(1) and the herd is
+    /// then resumed one owner at a time instead of all waking just to block on the mutex
+    struct async_condition_variable {
+        async_condition_variable() = default;
+
+        async_condition_variable(const async_condition_variable&) = delete;
+
+        async_condition_variable& operator=(const async_condition_variable&) = delete;
+
+        struct wait_awaitable : work_item {
+            async_condition_variable& cv;
+            async_mutex& mtx;
+
+            wait_awaitable(async_condition_variable& cv, async_mutex& mtx) : cv(cv), mtx(mtx) {}
+
+            bool await_ready() noexcept { return false; }
+
+            // the next owner of `mtx` runs in our place on this worker
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                {
+                    std::lock_guard lk{cv.m};
+                    cv.mtx = &mtx;
+                    cv.waiters.push_back(this);
+                }
+                auto* next = mtx.release();
+                return next ? next->handle : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        wait_awaitable wait(async_mutex& mtx) { return {*this, mtx}; }
+
+        template<class Pred>
+        task<> wait(async_mutex& mtx, Pred pred) {
+            while (!pred()) co_await wait(mtx);
+        }
+
+        void notify_one() {
+            work_queue q;
+            async_mutex* target;
+            {
+                std::lock_guard lk{m};
+                if (auto* w = waiters.pop_front()) q.push_back(w);
+                target = mtx;
+            }
+            if (target) target->requeue(q);
+        }
+
+        void notify_all() {
+            work_queue q;
+            async_mutex* target;
+            {
+                std::lock_guard lk{m};
+                q.splice_back(waiters);
+                target = mtx;
+            }
+            if (target) target->requeue(q);
+        }
+
+    private:
+        std::mutex m;
+        work_queue waiters;
+        async_mutex* mtx = nullptr;  // every waiter must use the same one
+    };
+
+    /// single-use countdown; `co_await latch.wait()` resumes once it reaches zero
+    ///
+    /// lock-free: waiters push themselves on an atomic stack and the final `count_down`
+    /// swaps in the "released" sentinel, so it never touches the latch again afterwards
+    /// (a released waiter is free to destroy it)
+    struct async_latch {
+        explicit async_latch(std::ptrdiff_t expected)
+                : remaining(expected), state(expected > 0 ? nullptr : released()) {}
+
+        async_latch(const async_latch&) = delete;
+
+        async_latch& operator=(const async_latch&) = delete;
+
+        struct wait_awaitable : work_item {
+            async_latch& l;
+
+            explicit wait_awaitable(async_latch& l) : l(l) {}
+
+            bool await_ready() noexcept { return l.try_wait(); }
+
+            bool await_suspend(std::coroutine_handle<> h) noexcept {
+                handle = h;
+                auto* old = l.state.load(std::memory_order_acquire);
+                do {
+                    if (old == l.released()) return false;
+                    next = static_cast<work_item*>(old);
+                } while (!l.state.compare_exchange_weak(old, static_cast<work_item*>(this),
+                                                       std::memory_order_release, std::memory_order_acquire));
+                return true;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        // the waiters are scheduled, not run here
+        void count_down(std::ptrdiff_t n = 1) { arrive(n, false); }
+
+        bool try_wait() const noexcept { return state.load(std::memory_order_acquire) == released(); }
+
+        wait_awaitable wait() { return wait_awaitable{*this}; }
+
+        // the last arrival hands its worker to a lone waiter before carrying on
+        struct arrive_awaitable : wait_awaitable {
+            std::ptrdiff_t n;
+
+            arrive_awaitable(async_latch& l, std::ptrdiff_t n) : wait_awaitable(l), n(n) {}
+
+            bool await_ready() noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> h) noexcept {
+                // released: a waiter may have destroyed the latch already
+                if (l.arrive(n, true)) return false;
+                return wait_awaitable::await_suspend(h);
+            }
+        };
+
+        arrive_awaitable arrive_and_wait(std::ptrdiff_t n = 1) { return arrive_awaitable{*this, n}; }
+
+    private:
+        friend struct async_barrier;
+
+        std::atomic<std::ptrdiff_t> remaining;
+        std::atomic<void*> state;  // nullptr, a waiter stack, or `released()`
+
+        void* released() const noexcept { return const_cast<async_latch*>(this); }
+
+        // true: this was the arrival that released the latch
+        bool arrive(std::ptrdiff_t n, bool from_suspend) {
+            if (remaining.fetch_sub(n, std::memory_order_acq_rel) != n) return false;
+            auto* w = static_cast<work_item*>(state.exchange(released(), std::memory_order_acq_rel));
+            // the stack is LIFO: rebuild arrival order
+            work_queue q;
+            work_item* fifo = nullptr;
+            while (w) {
+                auto* next = w->next;
+                w->next = fifo;
+                fifo = w;
+                w = next;
+            }
+            while (fifo) {
+                auto* next = fifo->next;
+                q.push_back(fifo);
+                fifo = next;
+            }
+            wake_all(q, from_suspend);
+            return true;
+        }
+
+        // only a suspending coroutine may run a waiter on its own stack: it holds no locks
+        // and touches nothing after handing off
+        static void wake_all(work_queue& q, bool from_suspend) {
+            if (q.empty()) return;
+            if (auto* ex = executor::current()) {
+                // a lone waiter is usually a task waiting for the one that arrived
+                if (from_suspend && q.size() == 1) {
+                    ex->dispatch(q.pop_front());
+                } else {
+                    ex->schedule(q);
+                }
+                return;
+            }
+            while (auto* w = q.pop_front()) w->handle.resume();
+        }
+    };
+
+    /// reusable phase barrier: the last of `expected` arrivals releases the whole phase
+    /// at once and carries on without suspending
+    struct async_barrier {
+        explicit async_barrier(std::ptrdiff_t expected) : expected(expected), remaining(expected) {}
+
+        async_barrier(const async_barrier&) = delete;
+
+        async_barrier& operator=(const async_barrier&) = delete;
+
+        struct arrive_awaitable : work_item {
+            async_barrier& b;
+
+            explicit arrive_awaitable(async_barrier& b) : b(b) {}
+
+            bool await_ready() noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                work_queue q;
+                {
+                    std::lock_guard lk{b.m};
+                    if (--b.remaining > 0) {
+                        b.waiters.push_back(this);
+                        return true;
+                    }
+                    q = b.next_phase_locked();
+                }
+                async_latch::wake_all(q, true);
+                return false;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        arrive_awaitable arrive_and_wait() { return arrive_awaitable{*this}; }
+
+        // leave for good; may complete the current phase
+        void arrive_and_drop() {
+            work_queue q;
+            {
+                std::lock_guard lk{m};
+                --expected;
+                if (--remaining > 0) return;
+                q = next_phase_locked();
+            }
+            async_latch::wake_all(q, false);
+        }
+
+        std::size_t phase() {
+            std::lock_guard lk{m};
+            return current_phase;
+        }
+
+    private:
+        std::mutex m;
+        std::ptrdiff_t expected;
+        std::ptrdiff_t remaining;
+        std::size_t current_phase = 0;
+        work_queue waiters;
+
+        work_queue next_phase_locked() {
+            remaining = expected;
+            ++current_phase;
+            return std::exchange(waiters, {});
+        }
+    };
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <source_location>
+#include <stop_token>
+#include <utility>
+#include <variant>
+
+#include "frame_registry.hpp"
+#include "stats.hpp"
+
+namespace co {
+    /// thrown out of a cancellable `co_await` once the task's stop token is triggered
+    struct operation_cancelled : std::exception {
+        const char* what() const noexcept override { return "co::operation_cancelled"; }
+    };
+
+    namespace detail {
+        // what `co::fork` / `co::join` keep in the forking task: children still running plus
+        // one for the task itself until it joins, and the first exception a child threw
+        struct join_state {
+            std::atomic<std::uint32_t> outstanding{1};
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+        };
+
+        // what `co_return` stores in the promise: a value or the escaped exception
+        template<class T>
+        struct task_result {
+            std::variant<std::monostate, T, std::exception_ptr> value;
+
+            void return_value(T v) { value.template emplace<1>(std::move(v)); }
+
+            void unhandled_exception() noexcept { value.template emplace<2>(std::current_exception()); }
+
+            T get() {
+                if (value.index() == 2) std::rethrow_exception(std::get<2>(value));
+                return std::move(std::get<1>(value));
+            }
+        };
+
+        template<>
+        struct task_result<void> {
+            std::exception_ptr error;
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+
+            void get() {
+                if (error) std::rethrow_exception(error);
+            }
+        };
+    }
+
+    /// lazy task: nothing runs until it is `co_await`ed
+    /// the awaiting coroutine is stored as `continuation` and resumed from `final_suspend`
+    /// by symmetric transfer, so a chain of tasks never grows the native stack
+    ///
+    /// `stop` is inherited from the awaiting task unless set beforehand; cancellable
+    /// awaitables find it through their templated `await_suspend`
+    template<class T = void>
+    struct task {
+        struct promise_t : detail::task_result<T>, detail::counted_frame, detail::tracked_frame {
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+            std::stop_token stop;
+            detail::join_state joins;
+
+            // the default argument resolves to the coroutine's own definition
+            promise_t(std::source_location loc = std::source_location::current()) : detail::tracked_frame(loc) {}
+
+            task get_return_object() {
+                return task{std::coroutine_handle<promise_t>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct final_awaitable {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept {
+                    return h.promise().continuation;
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            final_awaitable final_suspend() noexcept { return {}; }
+        };
+
+        /// trait
+        using promise_type = promise_t;
+
+        using handle_t = std::coroutine_handle<promise_type>;
+        handle_t handle;
+
+        explicit task(handle_t h) : handle(h) {}
+
+        task(task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+        task& operator=(task&& other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        // unlike `ret_t` in main.cpp, the frame is owned and destroyed here
+        ~task() {
+            if (handle) handle.destroy();
+        }
+
+        struct awaitable {
+            handle_t h;
+
+            bool await_ready() noexcept { return false; }
+
+            template<class P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> caller) noexcept {
+                if constexpr (requires { caller.promise().stop; }) {
+                    if (!h.promise().stop.stop_possible()) h.promise().stop = caller.promise().stop;
+                }
+                h.promise().continuation = caller;
+                return h;
+            }
+
+            T await_resume() { return h.promise().get(); }
+        };
+
+        awaitable operator co_await() && noexcept { return awaitable{handle}; }
+    };
+
+    /// `auto token = co_await co::get_stop_token();` inside a task
+    struct get_stop_token_awaitable {
+        std::stop_token token;
+
+        bool await_ready() noexcept { return false; }
+
+        template<class P>
+        bool await_suspend(std::coroutine_handle<P> h) noexcept {
+            token = h.promise().stop;
+            return false;
+        }
+
+        std::stop_token await_resume() noexcept { return std::move(token); }
+    };
+
+    inline get_stop_token_awaitable get_stop_token() noexcept { return {}; }
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include <time.h>
+
+#include "stats.hpp"
+
+namespace co {
+    /// an intrusive timer: embed it (or derive from it) and set `fire`
+    /// `fire` runs on the wheel's driver thread, outside the wheel lock
+    struct timer_node {
+        timer_node* prev = nullptr;
+        timer_node* next = nullptr;
+        std::uint64_t expiry = 0;  // in ticks
+        bool linked = false;
+
+        void (*fire)(timer_node*) = nullptr;
+    };
+
+    /// `CLOCK_MONOTONIC_COARSE`: the time the kernel cached at its last scheduler tick,
+    /// read without touching the hardware clock, and up to `resolution()` behind
+    /// shares `steady_clock`'s epoch
+    struct coarse_clock {
+        using duration = std::chrono::steady_clock::duration;
+        using time_point = std::chrono::steady_clock::time_point;
+
+        static time_point now() noexcept {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return time_point{std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec}};
+        }
+
+        static duration resolution() noexcept {
+            static const duration res = [] {
+                timespec ts;
+                clock_getres(CLOCK_MONOTONIC_COARSE, &ts);
+                return duration{std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec}};
+            }();
+            return res;
+        }
+    };
+
+    /// hashed timing wheel: 1 ms ticks, `slots` buckets, timers further out stay in their
+    /// bucket for more than one revolution
+    /// arm / cancel are O(1); a driver thread sleeps until the next non-empty bucket
+    ///
+    /// a timer armed with `slack` may fire up to that much late, and the wheel uses it to
+    /// fire fewer batches: the expiry moves onto a tick the driver already wakes for, or
+    /// else up to a multiple of the largest power of two ticks that fits, where timers
+    /// armed around the same time meet. a slack of at least `coarse_clock::resolution()`
+    /// also reads the coarse clock instead of the precise one, its lag counted as slack
+    struct timer_wheel {
+        using clock = std::chrono::steady_clock;
+        static constexpr auto tick = std::chrono::milliseconds{1};
+        static constexpr std::size_t slots = 512;
+
+        timer_wheel() : start(clock::now()), driver([this] { drive(); }) {}
+
+        ~timer_wheel() {
+            {
+                std::lock_guard lk{m};
+                stopping = true;
+            }
+            cv.notify_one();
+            driver.join();
+        }
+
+        timer_wheel(const timer_wheel&) = delete;
+
+        timer_wheel& operator=(const timer_wheel&) = delete;
+
+        void arm(timer_node* n, clock::duration d, clock::duration slack = {}) {
+            bool wake;
+            {
+                std::lock_guard lk{m};
+                clock::time_point now;
+                if (slack >= coarse_clock::resolution()) {
+                    // the real time is at most one resolution past the coarse one
+                    now = coarse_clock::now() + coarse_clock::resolution();
+                    slack -= coarse_clock::resolution();
+                } else {
+                    now = clock::now();
+                }
+                // the first tick at or after the deadline: a timer never fires early
+                auto due = static_cast<std::uint64_t>((now + d - start + tick - clock::duration{1}) / tick);
+                n->expiry = coalesce(std::max(due, tick_of(now) + 1), static_cast<std::uint64_t>(slack / tick));
+                link(n);
+                wake = n->expiry < wake_tick;
+            }
+            if (wake) cv.notify_one();
+        }
+
+        // false: the timer already fired (or is firing right now)
+        bool cancel(timer_node* n) {
+            std::lock_guard lk{m};
+            if (!n->linked) return false;
+            unlink(n);
+            return true;
+        }
+
+        std::size_t size() const {
+            std::lock_guard lk{m};
+            return count;
+        }
+
+    private:
+        struct bucket {
+            timer_node* head = nullptr;
+        };
+
+        mutable std::mutex m;
+        std::condition_variable cv;
+        std::array<bucket, slots> wheel{};
+        std::size_t count = 0;
+        std::uint64_t current = 0;  // every tick before this has been processed
+        std::uint64_t wake_tick = UINT64_MAX;  // when the driver plans to look again
+        bool stopping = false;
+        clock::time_point start;
+        std::thread driver;
+
+        std::uint64_t tick_of(clock::time_point t) const {
+            return static_cast<std::uint64_t>((t - start) / tick);
+        }
+
+        std::uint64_t now_tick() const { return tick_of(clock::now()); }
+
+        // the tick a timer due at `expiry` fires on, at most `slack` later
+        std::uint64_t coalesce(std::uint64_t expiry, std::uint64_t slack) const {
+            if (slack == 0) return expiry;
+            if (wake_tick >= expiry && wake_tick - expiry <= slack) return wake_tick;
+            auto align = std::bit_floor(slack);
+            return (expiry + align - 1) & ~(align - 1);
+        }
+
+        void link(timer_node* n) {
+            auto& b = wheel[n->expiry % slots];
+            n->prev = nullptr;
+            n->next = b.head;
+            if (b.head) b.head->prev = n;
+            b.head = n;
+            n->linked = true;
+            ++count;
+        }
+
+        void unlink(timer_node* n) {
+            if (n->prev) {
+                n->prev->next = n->next;
+            } else {
+                wheel[n->expiry % slots].head = n->next;
+            }
+            if (n->next) n->next->prev = n->prev;
+            n->prev = n->next = nullptr;
+            n->linked = false;
+            --count;
+        }
+
+        // first tick at or after `current` with a non-empty bucket, at most one revolution ahead
+        std::uint64_t next_busy_tick() const {
+            for (std::uint64_t t = current; t < current + slots; ++t) {
+                if (wheel[t % slots].head) return t;
+            }
+            return current + slots;
+        }
+
+        void drive() {
+            std::unique_lock lk{m};
+            while (!stopping) {
+                // collect everything that expired, reusing `next` as the list link
+                timer_node* expired = nullptr;
+                auto now = now_tick();
+                // after a long idle stretch one revolution visits every bucket
+                if (now >= current + slots) current = now - slots + 1;
+                for (; current <= now; ++current) {
+                    auto& b = wheel[current % slots];
+                    for (auto* n = b.head; n;) {
+                        auto* next = n->next;
+                        if (n->expiry <= now) {
+                            unlink(n);
+                            n->next = expired;
+                            expired = n;
+                        }
+                        n = next;
+                    }
+                }
+
+                if (expired) {
+                    lk.unlock();
+                    auto& counters = this_thread_counters();
+                    while (expired) {
+                        auto* n = expired;
+                        expired = n->next;
+                        n->next = nullptr;
+                        thread_counters::bump(counters.timers_fired);
+                        n->fire(n);  // may re-arm `n`
+                    }
+                    lk.lock();
+                    continue;
+                }
+
+                if (count == 0) {
+                    wake_tick = UINT64_MAX;
+                    cv.wait(lk);
+                } else {
+                    wake_tick = next_busy_tick();
+                    cv.wait_until(lk, start + wake_tick * tick);
+                }
+                thread_counters::bump(this_thread_counters().timer_wakeups);
+                wake_tick = 0;
+            }
+        }
+    };
+}
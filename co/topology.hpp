@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <sched.h>
+
+namespace co {
+    /// where a logical CPU sits: cpus with the same `core` are SMT siblings (`smt` numbers
+    /// them), the same `l3` share a last-level cache (`l3` is the lowest cpu id in that
+    /// cache's shared list)
+    struct cpu_info {
+        int id = 0;
+        int core = 0;
+        int package = 0;
+        int l3 = 0;
+        int smt = 0;
+    };
+
+    /// 0: same core, 1: same L3, 2: same package, 3: further apart
+    inline int distance(const cpu_info& a, const cpu_info& b) {
+        if (a.package == b.package && a.core == b.core) return 0;
+        if (a.l3 == b.l3) return 1;
+        if (a.package == b.package) return 2;
+        return 3;
+    }
+
+    /// how `executor` pins its workers
+    /// `reserved_cores` whole cores (all their SMT siblings) are kept free for the reactor
+    /// and listed in `placement_plan::reserved`. reserving every core leaves the workers
+    /// unpinned, with `placement_plan::unpinned` saying so
+    struct placement {
+        bool pin = false;
+        bool avoid_smt = false;
+        bool single_l3 = false;
+        std::size_t reserved_cores = 0;
+    };
+
+    struct placement_plan {
+        std::vector<cpu_info> workers;  // one per worker; empty when not pinning
+        std::vector<cpu_info> reserved;
+        const char* unpinned = nullptr;  // why `workers` is empty although `pin` was asked for
+    };
+
+    namespace detail {
+        inline int read_int(const std::string& path, int fallback) {
+            std::ifstream in{path};
+            int v = fallback;
+            in >> v;
+            return in ? v : fallback;
+        }
+
+        // "0-3,8,10-11"
+        inline std::vector<int> parse_cpu_list(const std::string& s) {
+            std::vector<int> out;
+            std::size_t i = 0;
+            while (i < s.size()) {
+                std::size_t end = 0;
+                int lo = std::stoi(s.substr(i), &end);
+                i += end;
+                int hi = lo;
+                if (i < s.size() && s[i] == '-') {
+                    hi = std::stoi(s.substr(i + 1), &end);
+                    i += end + 1;
+                }
+                for (int c = lo; c <= hi; ++c) out.push_back(c);
+                while (i < s.size() && (s[i] == ',' || s[i] == '\n')) ++i;
+            }
+            return out;
+        }
+
+        inline std::string read_line(const std::string& path) {
+            std::ifstream in{path};
+            std::string s;
+            std::getline(in, s);
+            return s;
+        }
+    }
+
+    /// the cpus this process may run on, read from `/sys/devices/system/cpu`
+    struct cpu_topology {
+        // one thread of every core, by cache domain, before any second threads: the first
+        // n entries share an L3 where possible, and a core only once every core of every
+        // domain has one
+        std::vector<cpu_info> cpus;
+
+        static cpu_topology read() {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return {};
+
+            cpu_topology t;
+            const std::string root = "/sys/devices/system/cpu/";
+            auto online = detail::read_line(root + "online");
+            for (int id: detail::parse_cpu_list(online)) {
+                if (!CPU_ISSET(id, &allowed)) continue;
+                auto dir = root + "cpu" + std::to_string(id) + "/";
+                cpu_info c{id, id, 0, -1, 0};
+                c.core = detail::read_int(dir + "topology/core_id", id);
+                c.package = detail::read_int(dir + "topology/physical_package_id", 0);
+                for (int idx = 0;; ++idx) {
+                    auto cache = dir + "cache/index" + std::to_string(idx) + "/";
+                    int level = detail::read_int(cache + "level", -1);
+                    if (level < 0) break;
+                    if (level != 3) continue;
+                    auto shared = detail::parse_cpu_list(detail::read_line(cache + "shared_cpu_list"));
+                    if (!shared.empty()) c.l3 = shared.front();
+                }
+                // no L3 listed: treat the package as the cache domain
+                if (c.l3 < 0) c.l3 = -1 - c.package;
+                t.cpus.push_back(c);
+            }
+            for (auto& c: t.cpus) {
+                c.smt = static_cast<int>(std::count_if(t.cpus.begin(), t.cpus.end(), [&](const cpu_info& o) {
+                    return o.package == c.package && o.core == c.core && o.id < c.id;
+                }));
+            }
+            t.sort();
+            return t;
+        }
+
+        void sort() {
+            std::sort(cpus.begin(), cpus.end(), [](const cpu_info& a, const cpu_info& b) {
+                return std::tie(a.smt, a.l3, a.package, a.core) < std::tie(b.smt, b.l3, b.package, b.core);
+            });
+        }
+
+        placement_plan plan(const placement& p, std::size_t n_workers) const {
+            placement_plan out;
+            if (!p.pin) return out;
+            if (cpus.empty()) {
+                out.unpinned = "no cpu topology";
+                return out;
+            }
+            auto usable = cpus;
+
+            if (p.single_l3) {
+                // the domain with the most cpus available to us
+                std::map<int, std::size_t> per_l3;
+                for (auto& c: usable) ++per_l3[c.l3];
+                auto best = std::max_element(per_l3.begin(), per_l3.end(),
+                                             [](auto& a, auto& b) { return a.second < b.second; })->first;
+                std::erase_if(usable, [&](const cpu_info& c) { return c.l3 != best; });
+            }
+
+            // whole cores off the end, so the reactor keeps its SMT sibling to itself
+            for (std::size_t r = 0; r < p.reserved_cores && !usable.empty(); ++r) {
+                auto last = usable.back();
+                for (auto it = usable.begin(); it != usable.end();) {
+                    if (it->package == last.package && it->core == last.core) {
+                        out.reserved.push_back(*it);
+                        it = usable.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            if (p.avoid_smt) {
+                std::vector<cpu_info> one_per_core;
+                for (auto& c: usable) {
+                    bool seen = std::any_of(one_per_core.begin(), one_per_core.end(), [&](const cpu_info& o) {
+                        return o.package == c.package && o.core == c.core;
+                    });
+                    if (!seen) one_per_core.push_back(c);
+                }
+                usable = std::move(one_per_core);
+            }
+
+            // everything reserved: leave the workers to the scheduler, and say so
+            if (usable.empty()) {
+                out.unpinned = "reserved_cores leaves no cpu for the workers";
+                return out;
+            }
+            for (std::size_t i = 0; i < n_workers; ++i) out.workers.push_back(usable[i % usable.size()]);
+            return out;
+        }
+    };
+
+    /// pins the calling thread; false if the kernel refused
+    inline bool pin_this_thread(int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// lazy adaptors for `co::generator` (or anything else with `begin()` / `end()`):
+///
+///     for (auto [i, t]: tokenize(s) | views::filter(is_ident) | views::take(10) | views::enumerate)
+///
+/// each stage is a plain iterator wrapping the one before it, so a pipeline still has
+/// just the one coroutine frame and one resume per element pulled from it. an adaptor
+/// owns a generator passed as an rvalue and refers to one passed as an lvalue
+namespace co::views {
+    namespace detail {
+        template<class R>
+        using iterator_t = decltype(std::declval<R&>().begin());
+
+        template<class R>
+        using reference_t = decltype(*std::declval<iterator_t<R>&>());
+
+        template<class R>
+        using value_t = std::remove_cvref_t<reference_t<R>>;
+
+        template<class R>
+        concept range = requires(R& r) {
+            r.begin();
+            r.end();
+        };
+
+        // what `|` takes: builds the view once it is given a range
+        template<class Make>
+        struct closure {
+            Make make;
+
+            template<range R>
+            friend auto operator|(R&& r, closure c) { return c.make(std::forward<R>(r)); }
+        };
+    }
+
+    template<class R, class F>
+    struct map_view {
+        R base;
+        F f;
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::remove_cvref_t<std::invoke_result_t<F&, detail::reference_t<R>>>;
+
+            map_view* v;
+            detail::iterator_t<R> it;
+
+            decltype(auto) operator*() const { return v->f(*it); }
+
+            iterator& operator++() {
+                ++it;
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& i, std::default_sentinel_t) { return i.it == i.v->base.end(); }
+        };
+
+        iterator begin() { return {this, base.begin()}; }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    template<class R, class P>
+    struct filter_view {
+        R base;
+        P pred;
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = detail::value_t<R>;
+
+            filter_view* v;
+            detail::iterator_t<R> it;
+
+            void skip() {
+                while (!(it == v->base.end()) && !v->pred(*it)) ++it;
+            }
+
+            decltype(auto) operator*() const { return *it; }
+
+            iterator& operator++() {
+                ++it;
+                skip();
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& i, std::default_sentinel_t) { return i.it == i.v->base.end(); }
+        };
+
+        iterator begin() {
+            iterator i{this, base.begin()};
+            i.skip();
+            return i;
+        }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    /// stops without resuming the source again once `n` elements were handed out
+    template<class R>
+    struct take_view {
+        R base;
+        std::size_t n;
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = detail::value_t<R>;
+
+            take_view* v;
+            detail::iterator_t<R> it;
+            std::size_t left;
+
+            decltype(auto) operator*() const { return *it; }
+
+            iterator& operator++() {
+                if (--left > 0) ++it;
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& i, std::default_sentinel_t) {
+                return i.left == 0 || i.it == i.v->base.end();
+            }
+        };
+
+        // not even the first resume when nothing is wanted
+        iterator begin() { return n ? iterator{this, base.begin(), n} : iterator{this, {}, 0}; }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    /// groups of up to `n` elements as a `std::span` into a buffer owned by the view
+    /// elements are copied: a generator's `co_yield`ed value only lives until it resumes
+    template<class R>
+    struct chunk_view {
+        R base;
+        std::size_t n;
+        std::vector<detail::value_t<R>> buffer;
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::span<const detail::value_t<R>>;
+
+            chunk_view* v;
+            detail::iterator_t<R> it;
+
+            void fill() {
+                v->buffer.clear();
+                while (v->buffer.size() < v->n && !(it == v->base.end())) {
+                    v->buffer.push_back(*it);
+                    // the last element of a chunk waits here until the next one is wanted
+                    if (v->buffer.size() < v->n) ++it;
+                }
+            }
+
+            value_type operator*() const { return {v->buffer}; }
+
+            iterator& operator++() {
+                if (!(it == v->base.end())) ++it;
+                fill();
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& i, std::default_sentinel_t) { return i.v->buffer.empty(); }
+        };
+
+        iterator begin() {
+            buffer.reserve(n);
+            iterator i{this, base.begin()};
+            i.fill();
+            return i;
+        }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    template<class Ref>
+    struct indexed {
+        std::size_t index;
+        Ref value;
+    };
+
+    template<class R>
+    struct enumerate_view {
+        R base;
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = indexed<detail::reference_t<R>>;
+
+            enumerate_view* v;
+            detail::iterator_t<R> it;
+            std::size_t index = 0;
+
+            value_type operator*() const { return {index, *it}; }
+
+            iterator& operator++() {
+                ++it;
+                ++index;
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& i, std::default_sentinel_t) { return i.it == i.v->base.end(); }
+        };
+
+        iterator begin() { return {this, base.begin()}; }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    /// the elements of a range of contiguous chunks (anything with `data()` and `size()`,
+    /// e.g. the `std::span`s of a `chunked_generator`), one at a time
+    /// the current chunk is copied into the iterator, which is cheap for a span
+    template<class R>
+    struct flatten_view {
+        R base;
+
+        struct iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::remove_cvref_t<decltype(*std::declval<detail::value_t<R>&>().data())>;
+
+            flatten_view* v;
+            detail::iterator_t<R> it;
+            detail::value_t<R> chunk{};
+            std::size_t i = 0;
+
+            // skips empty chunks
+            void settle() {
+                while (i == chunk.size() && !(it == v->base.end())) {
+                    chunk = *it;
+                    i = 0;
+                    if (chunk.size() == 0) ++it;
+                }
+            }
+
+            decltype(auto) operator*() const { return chunk.data()[i]; }
+
+            iterator& operator++() {
+                if (++i == chunk.size()) {
+                    ++it;
+                    settle();
+                }
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& i, std::default_sentinel_t) { return i.it == i.v->base.end(); }
+        };
+
+        iterator begin() {
+            iterator i{this, base.begin()};
+            i.settle();
+            return i;
+        }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    template<class F>
+    auto map(F f) {
+        return detail::closure{[f = std::move(f)]<class R>(R&& r) mutable {
+            return map_view<R, F>{std::forward<R>(r), std::move(f)};
+        }};
+    }
+
+    template<class P>
+    auto filter(P pred) {
+        return detail::closure{[pred = std::move(pred)]<class R>(R&& r) mutable {
+            return filter_view<R, P>{std::forward<R>(r), std::move(pred)};
+        }};
+    }
+
+    inline auto take(std::size_t n) {
+        return detail::closure{[n]<class R>(R&& r) { return take_view<R>{std::forward<R>(r), n}; }};
+    }
+
+    inline auto chunk(std::size_t n) {
+        return detail::closure{[n]<class R>(R&& r) { return chunk_view<R>{std::forward<R>(r), n, {}}; }};
+    }
+
+    inline constexpr detail::closure flatten{[]<class R>(R&& r) { return flatten_view<R>{std::forward<R>(r)}; }};
+
+    inline constexpr detail::closure enumerate{[]<class R>(R&& r) { return enumerate_view<R>{std::forward<R>(r)}; }};
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "async_generator.hpp"
+#include "executor.hpp"
+#include "queue.hpp"
+
+namespace co {
+    /// one entry of a `walk_dir`; `dir` and `name` point into the walker's buffers and
+    /// stay valid until the next entry is asked for
+    struct dir_entry {
+        std::string_view dir;  // the parent as reached from the root, e.g. "root/a/b"
+        std::string_view name;
+        std::uint64_t ino = 0;
+        unsigned char type = DT_UNKNOWN;  // a `DT_*`
+
+        bool is_dir() const noexcept { return type == DT_DIR; }
+
+        // allocates, so only for the entries that need a path of their own
+        std::string path() const {
+            std::string p;
+            p.reserve(dir.size() + 1 + name.size());
+            p += dir;
+            if (!dir.empty() && dir.back() != '/') p += '/';
+            p += name;
+            return p;
+        }
+    };
+
+    struct walk_options {
+        std::size_t parallelism = 4;  // directories read at once
+        std::size_t buffer_size = 256 * 1024;  // bytes asked for by each getdents64
+    };
+
+    namespace detail {
+        inline bool is_dot(const char* name) noexcept {
+            return name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0));
+        }
+
+        // what one getdents64 returned for `dir`, handed to the consumer as is
+        struct dir_batch {
+            std::shared_ptr<const std::string> dir;
+            std::unique_ptr<std::byte[]> buf;
+            std::size_t size = 0;
+        };
+
+        struct walk_state : std::enable_shared_from_this<walk_state> {
+            executor& ex;
+            const walk_options opts;
+            const std::shared_ptr<const std::string> root;
+            async_queue<dir_batch> out;
+
+            walk_state(executor& ex, std::string root, walk_options o)
+                    : ex(ex), opts{o.parallelism ? o.parallelism : 1, std::max<std::size_t>(o.buffer_size, 4096)},
+                      root(std::make_shared<const std::string>(std::move(root))), out(ex, opts.parallelism) {}
+
+            // queues a directory, and starts another reader if fewer than `parallelism` run
+            void add_dir(std::shared_ptr<const std::string> dir) {
+                {
+                    std::lock_guard lk{m};
+                    if (stopped) return;
+                    pending.push_back(std::move(dir));
+                    ++outstanding;
+                    if (readers >= opts.parallelism) return;
+                    ++readers;
+                }
+                ex.spawn(read_dirs(shared_from_this()));
+            }
+
+            std::unique_ptr<std::byte[]> buffer() {
+                std::lock_guard lk{m};
+                if (spare.empty()) return std::make_unique_for_overwrite<std::byte[]>(opts.buffer_size);
+                auto b = std::move(spare.back());
+                spare.pop_back();
+                return b;
+            }
+
+            void recycle(std::unique_ptr<std::byte[]> b) {
+                std::lock_guard lk{m};
+                spare.push_back(std::move(b));
+            }
+
+            void fail(int err) {
+                {
+                    std::lock_guard lk{m};
+                    if (!error) error = std::error_code{err, std::system_category()};
+                    stopped = true;
+                }
+                out.close();
+            }
+
+            // pending pushes fail and readers wind down; also when the consumer stops early
+            void stop() {
+                {
+                    std::lock_guard lk{m};
+                    stopped = true;
+                }
+                out.close();
+            }
+
+            std::error_code failure() {
+                std::lock_guard lk{m};
+                return error;
+            }
+
+        private:
+            std::mutex m;
+            std::deque<std::shared_ptr<const std::string>> pending;
+            std::vector<std::unique_ptr<std::byte[]>> spare;
+            std::size_t readers = 0;
+            std::size_t outstanding = 0;  // directories queued or being read
+            std::error_code error;
+            bool stopped = false;
+
+            // null once there is nothing left for this reader, which then counts itself out
+            std::shared_ptr<const std::string> take_dir() {
+                std::lock_guard lk{m};
+                if (stopped || pending.empty()) {
+                    --readers;
+                    return nullptr;
+                }
+                auto dir = std::move(pending.front());
+                pending.pop_front();
+                return dir;
+            }
+
+            void finish_dir() {
+                {
+                    std::lock_guard lk{m};
+                    if (--outstanding != 0) return;
+                }
+                out.close();
+            }
+
+            static task<> read_dirs(std::shared_ptr<walk_state> self) {
+                while (auto dir = self->take_dir()) co_await self->read_dir(std::move(dir));
+            }
+
+            // each getdents64 blocks the worker it runs on; `parallelism` bounds how many
+            task<> read_dir(std::shared_ptr<const std::string> dir) {
+                int fd = ::open(dir->c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                if (fd < 0) {
+                    // a subdirectory that went away or may not be read is skipped, like
+                    // `directory_options::skip_permission_denied`; the root has to open
+                    if (dir == root || (errno != ENOENT && errno != EACCES && errno != ENOTDIR)) fail(errno);
+                    finish_dir();
+                    co_return;
+                }
+                for (;;) {
+                    auto buf = buffer();
+                    auto n = ::syscall(SYS_getdents64, fd, buf.get(), opts.buffer_size);
+                    if (n <= 0) {
+                        if (n < 0) fail(errno);
+                        recycle(std::move(buf));
+                        break;
+                    }
+                    // subdirectories are queued before the batch goes out, so other readers
+                    // can start on them while this one waits for the consumer
+                    for (std::size_t at = 0; at < std::size_t(n);) {
+                        auto* d = reinterpret_cast<dirent64*>(buf.get() + at);
+                        at += d->d_reclen;
+                        if (is_dot(d->d_name)) continue;
+                        if (d->d_type == DT_UNKNOWN) {
+                            struct stat st{};
+                            if (::fstatat(fd, d->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) d->d_type = IFTODT(st.st_mode);
+                        }
+                        if (d->d_type == DT_DIR) {
+                            add_dir(std::make_shared<const std::string>(dir_entry{*dir, d->d_name}.path()));
+                        }
+                    }
+                    // named: GCC 12 frees the buffer twice when the batch is a temporary in the operand
+                    dir_batch b{dir, std::move(buf), std::size_t(n)};
+                    if (!co_await out.push(std::move(b))) break;
+                }
+                ::close(fd);
+                finish_dir();
+            }
+        };
+    }
+
+    /// every entry under `root`. directories are taken breadth first, up to `parallelism`
+    /// of them read at once, so entries of different directories come in no fixed order:
+    ///
+    ///     auto walk = co::walk_dir("/data");
+    ///     while (auto* e = co_await walk.next()) if (!e->is_dir()) ++files;
+    ///
+    /// entries are read with getdents64 into `buffer_size` buffers that go to the consumer
+    /// whole, so there is no allocation per entry: only one string per directory, and the
+    /// buffers are recycled. at most about 3 * `parallelism` buffers exist at once
+    ///
+    /// symlinks are reported, not followed. subdirectories that vanish or may not be read
+    /// are skipped; any other error, or a root that does not open, ends the walk with a
+    /// `std::system_error` from `next()`. must be consumed on an executor worker, where
+    /// the readers are spawned
+    inline async_generator<dir_entry> walk_dir(std::string root, walk_options opts = {}) {
+        auto* ex = executor::current();
+        if (!ex) throw std::logic_error("co::walk_dir must be consumed on an executor worker");
+        auto s = std::make_shared<detail::walk_state>(*ex, std::move(root), opts);
+        struct stopper {
+            detail::walk_state& s;
+
+            ~stopper() { s.stop(); }
+        } guard{*s};
+
+        s->add_dir(s->root);
+        std::vector<detail::dir_batch> got(s->opts.parallelism);
+        while (auto n = co_await s->out.pop_batch(got, got.size())) {
+            for (auto& b: std::span{got}.first(n)) {
+                dir_entry e{.dir = *b.dir, .name = {}, .ino = 0, .type = DT_UNKNOWN};
+                for (std::size_t at = 0; at < b.size;) {
+                    auto* d = reinterpret_cast<const dirent64*>(b.buf.get() + at);
+                    at += d->d_reclen;
+                    if (detail::is_dot(d->d_name)) continue;
+                    e.name = d->d_name;
+                    e.ino = d->d_ino;
+                    e.type = d->d_type;
+                    co_yield e;
+                }
+                s->recycle(std::move(b.buf));
+                b.dir.reset();
+            }
+        }
+        if (auto err = s->failure()) throw std::system_error(err, "co::walk_dir");
+    }
+}
@@ -0,0 +1,119 @@
+// the write-then-rename publish pattern of a storage service, on one executor worker:
+// create a temp file, fallocate, write, fsync, close, statx, rename into place, and
+// finally unlink everything. done once with plain syscalls inside the coroutines and
+// once through the reactor, while a heartbeat task on the same worker ticks every
+// millisecond: its longest gap shows how long the worker was blocked
+//
+//   ./files [files]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "co/reactor.hpp"
+#include "co/sync.hpp"
+
+using namespace std::chrono_literals;
+using clock_type = std::chrono::steady_clock;
+
+struct heartbeat {
+    bool stop = false;
+    clock_type::duration longest{};
+};
+
+co::task<> beat(heartbeat& h, co::async_latch& done) {
+    auto last = clock_type::now();
+    while (!h.stop) {
+        co_await co::sleep_for(1ms);
+        auto now = clock_type::now();
+        h.longest = std::max(h.longest, now - last);
+        last = now;
+    }
+    done.count_down();
+}
+
+const std::string record(4096, 'x');
+
+// returns the size statx saw, or -errno
+co::task<long> publish_blocking(const std::string& dir, int i) {
+    auto tmp = dir + "/tmp." + std::to_string(i);
+    auto final = dir + "/file." + std::to_string(i);
+    int fd = ::openat(AT_FDCWD, tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) co_return -errno;
+    ::fallocate(fd, 0, 0, 64 * 1024);
+    ::pwrite(fd, record.data(), record.size(), 0);
+    ::fdatasync(fd);
+    ::close(fd);
+    struct statx st{};
+    ::statx(AT_FDCWD, tmp.c_str(), 0, STATX_SIZE, &st);
+    ::renameat(AT_FDCWD, tmp.c_str(), AT_FDCWD, final.c_str());
+    co_return static_cast<long>(st.stx_size);
+}
+
+co::task<long> publish(co::reactor& io, const std::string& dir, int i) {
+    auto tmp = dir + "/tmp." + std::to_string(i);
+    auto final = dir + "/file." + std::to_string(i);
+    int fd = co_await io.openat(AT_FDCWD, tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) co_return fd;
+    // nothing here depends on a result but the last: one chain, one wakeup
+    auto [alloc, written, synced, closed] =
+            co_await co::link(io.fallocate(fd, 0, 0, 64 * 1024), io.write(fd, std::as_bytes(std::span{record}), 0),
+                              io.fsync(fd, true), io.close_fd(fd));
+    if (alloc < 0 || written < 0 || synced < 0 || closed < 0) co_return -EIO;
+    struct statx st{};
+    co_await io.statx(AT_FDCWD, tmp.c_str(), 0, STATX_SIZE, &st);
+    if (int rc = co_await io.renameat(AT_FDCWD, tmp.c_str(), AT_FDCWD, final.c_str()); rc < 0) co_return rc;
+    co_return static_cast<long>(st.stx_size);
+}
+
+co::task<> one(co::reactor* io, const std::string& dir, int i, long& total, co::async_latch& done) {
+    if (io) {
+        total += co_await publish(*io, dir, i);
+    } else {
+        total += co_await publish_blocking(dir, i);
+    }
+    done.count_down();
+}
+
+co::task<> cleanup(co::reactor& io, const std::string& dir, int files) {
+    for (int i = 0; i < files; ++i) co_await io.unlinkat(AT_FDCWD, (dir + "/file." + std::to_string(i)).c_str());
+    co_await io.unlinkat(AT_FDCWD, dir.c_str(), AT_REMOVEDIR);
+}
+
+co::task<> run(co::reactor& io, bool use_reactor, int files) {
+    char tmpl[] = "/tmp/co_files_XXXXXX";
+    std::string dir = mkdtemp(tmpl);
+    heartbeat h;
+    co::async_latch beating{1};
+    auto* ex = co::executor::current();
+    ex->spawn(beat(h, beating));
+
+    auto start = clock_type::now();
+    long total = 0;
+    co::async_latch done{files};
+    for (int i = 0; i < files; ++i) ex->spawn(one(use_reactor ? &io : nullptr, dir, i, total, done));
+    co_await done.wait();
+    auto ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+    h.stop = true;
+    co_await beating.wait();
+
+    std::printf("%-9s %6d files %9.1f ms %10.1f ms %12ld\n", use_reactor ? "io_uring" : "blocking", files, ms,
+                std::chrono::duration<double, std::milli>(h.longest).count(), total);
+    co_await cleanup(io, dir, files);
+}
+
+int main(int argc, char** argv) {
+    int files = argc > 1 ? std::atoi(argv[1]) : 500;
+
+    co::executor ex{1};
+    co::reactor io{ex};
+    std::printf("%-9s %12s %12s %13s %12s\n", "", "", "time", "longest gap", "bytes");
+    for (bool use_reactor: {false, true}) ex.block_on(run(io, use_reactor, files));
+    return 0;
+}
@@ -0,0 +1,63 @@
+// built with CO_TRACK_FRAMES: finds a frame stuck on a mutex nobody unlocks, and at
+// shutdown the frames of a `ret_t`-style return object that never destroys its handle
+#include <chrono>
+#include <coroutine>
+#include <iostream>
+#include <source_location>
+#include <thread>
+
+#include "co/frame_registry.hpp"
+#include "co/sync.hpp"
+
+using namespace std::chrono_literals;
+
+// the bug from main.cpp: `final_suspend` suspends and nobody ever calls `destroy`
+struct leaky_t {
+    struct promise_t : co::detail::tracked_frame {
+        promise_t(std::source_location loc = std::source_location::current()) : tracked_frame(loc) {}
+
+        leaky_t get_return_object() { return {std::coroutine_handle<promise_t>::from_promise(*this)}; }
+
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept {}
+    };
+
+    /// trait
+    using promise_type = promise_t;
+
+    std::coroutine_handle<promise_t> handle;
+};
+
+leaky_t fire_and_forget(int) {
+    co_await std::suspend_never{};
+}
+
+co::task<> forgets_to_unlock(co::async_mutex& m) {
+    co_await m.lock();
+}
+
+co::task<> waits_forever(co::async_mutex& m) {
+    auto guard = co_await m.scoped_lock();
+}
+
+int main() {
+    for (int i = 0; i < 3; ++i) fire_and_forget(i);
+
+    co::async_mutex m;
+    {
+        co::executor ex{2};
+        ex.block_on(forgets_to_unlock(m));
+        ex.spawn(waits_forever(m));
+        std::this_thread::sleep_for(200ms);
+
+        for (auto& f: co::stuck_frames(100ms)) std::cout << "stuck: " << f << "\n";
+    }
+
+    std::cout << co::report_live_frames(std::cout) << " frames still alive at exit\n";
+    return 0;
+}
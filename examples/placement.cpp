@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <sched.h>
+
+#include "co/executor.hpp"
+#include "co/topology.hpp"
+
+void print_plan(const char* name, const co::placement_plan& p) {
+    std::printf("%-24s workers:", name);
+    for (auto& c: p.workers) std::printf(" %d", c.id);
+    std::printf("   reserved:");
+    for (auto& c: p.reserved) std::printf(" %d", c.id);
+    if (p.unpinned) std::printf("   unpinned: %s", p.unpinned);
+    std::printf("\n");
+}
+
+void print_plans(const co::cpu_topology& t, std::size_t n) {
+    print_plan("spread", t.plan({.pin = true}, n));
+    print_plan("avoid smt", t.plan({.pin = true, .avoid_smt = true}, n));
+    print_plan("single l3", t.plan({.pin = true, .single_l3 = true}, n));
+    print_plan("avoid smt, 1 for reactor", t.plan({.pin = true, .avoid_smt = true, .reserved_cores = 1}, n));
+}
+
+co::task<int> where_am_i() { co_return sched_getcpu(); }
+
+int main() {
+    auto here = co::cpu_topology::read();
+    std::printf("this machine:\n");
+    for (auto& c: here.cpus) std::printf("  cpu %d: core %d, package %d, l3 %d\n", c.id, c.core, c.package, c.l3);
+    print_plans(here, 4);
+
+    // two L3 domains of eight cores with two hardware threads each, numbered the way
+    // Linux usually does: siblings are `n` and `n + 16`
+    co::cpu_topology two_sockets;
+    for (int id = 0; id < 32; ++id) {
+        int core = id % 16;
+        two_sockets.cpus.push_back({id, core % 8, core / 8, core / 8 * 8, id / 16});
+    }
+    two_sockets.sort();
+    std::printf("\n2 x 8 cores x 2 threads:\n");
+    print_plans(two_sockets, 12);
+
+    co::executor ex{2, {}, {.pin = true}};
+    std::printf("\npinned executor: task ran on cpu %d (worker 0 pinned to %d)\n", ex.block_on(where_am_i()),
+                ex.plan().workers.empty() ? -1 : ex.plan().workers[0].id);
+    return 0;
+}
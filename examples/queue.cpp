@@ -0,0 +1,40 @@
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include "co/queue.hpp"
+
+using namespace std::chrono_literals;
+
+// the writer pays one "fsync" per batch, so bigger batches mean fewer of them
+co::task<> writer(co::async_queue<int>& q, std::chrono::milliseconds linger) {
+    std::array<int, 64> batch;
+    int batches = 0, items = 0;
+    while (auto n = co_await q.pop_batch(batch, batch.size(), linger)) {
+        ++batches;
+        items += static_cast<int>(n);
+        co_await co::sleep_for(1ms);  // fsync
+    }
+    std::cout << "linger " << linger.count() << "ms: " << items << " items in " << batches << " batches" << std::endl;
+}
+
+co::task<> producer(co::async_queue<int>& q) {
+    for (int i = 0; i < 1000; ++i) {
+        co_await q.push(i);
+        if (i % 10 == 9) co_await co::sleep_for(1ms);
+    }
+    q.close();
+}
+
+co::task<> run(co::executor& ex, std::chrono::milliseconds linger) {
+    co::async_queue<int> q{ex, 256};
+    ex.spawn(producer(q));
+    co_await writer(q, linger);
+}
+
+int main() {
+    co::executor ex{2};
+    ex.block_on(run(ex, 0ms));
+    ex.block_on(run(ex, 5ms));
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <mutex>
+
+#include "co/rate_limiter.hpp"
+
+std::mutex out;
+
+co::task<> writer(co::rate_limiter& limiter, int tenant, std::latch& done) {
+    static const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        co_await limiter.acquire();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::lock_guard lk{out};
+        std::cout << "tenant " << tenant << " write " << i << " at " << ms.count() << "ms" << std::endl;
+    }
+    done.count_down();
+}
+
+int main() {
+    co::executor ex{2};
+    // one limiter per tenant: a burst of 5 writes, then 20 writes per second
+    co::rate_limiter a{ex, 5, 20.0};
+    co::rate_limiter b{ex, 5, 20.0};
+    std::latch done{3};
+    ex.spawn(writer(a, 0, done));
+    // tenant 1 and 2 share `b`, so each gets about half of it
+    ex.spawn(writer(b, 1, done));
+    ex.spawn(writer(b, 2, done));
+    done.wait();
+    return 0;
+}
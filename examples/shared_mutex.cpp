@@ -0,0 +1,70 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <map>
+
+#include "co/shared_mutex.hpp"
+#include "co/sync.hpp"
+
+// read-mostly routing table: many lookups, an update every 1000th operation
+struct routes {
+    std::map<int, int> table;
+    std::atomic<long> hits{0};
+};
+
+co::task<> reader_writer(co::async_shared_mutex& m, routes& r, int id, std::latch& done) {
+    for (int i = 0; i < 100'000; ++i) {
+        if (i % 1000 == 999) {
+            co_await m.lock();
+            r.table[id] = i;
+            m.unlock();
+        } else {
+            auto guard = co_await m.lock_shared();
+            if (r.table.count(i % 16)) r.hits.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    done.count_down();
+}
+
+co::task<> plain(co::async_mutex& m, routes& r, int id, std::latch& done) {
+    for (int i = 0; i < 100'000; ++i) {
+        auto guard = co_await m.scoped_lock();
+        if (i % 1000 == 999) {
+            r.table[id] = i;
+        } else if (r.table.count(i % 16)) {
+            r.hits.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    done.count_down();
+}
+
+template<class F>
+void measure(const char* name, F spawn_all) {
+    constexpr int n = 8;
+    std::latch done{n};
+    auto start = std::chrono::steady_clock::now();
+    spawn_all(n, done);
+    done.wait();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << name << ": " << ms.count() << "ms" << std::endl;
+}
+
+int main() {
+    co::executor ex{4};
+    {
+        routes r;
+        co::async_shared_mutex m;
+        measure("async_shared_mutex", [&](int n, std::latch& done) {
+            for (int i = 0; i < n; ++i) ex.spawn(reader_writer(m, r, i, done));
+        });
+    }
+    {
+        routes r;
+        co::async_mutex m;
+        measure("async_mutex", [&](int n, std::latch& done) {
+            for (int i = 0; i < n; ++i) ex.spawn(plain(m, r, i, done));
+        });
+    }
+    return 0;
+}
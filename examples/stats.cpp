@@ -0,0 +1,42 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <latch>
+#include <stop_token>
+
+#include "co/rate_limiter.hpp"
+#include "co/stats_exporter.hpp"
+#include "co/sync.hpp"
+
+using namespace std::chrono_literals;
+
+co::task<> busy(co::async_mutex& m, co::rate_limiter& limiter, std::latch& done) {
+    for (int i = 0; i < 2000; ++i) {
+        co_await limiter.acquire();
+        auto guard = co_await m.scoped_lock();
+        if (i % 100 == 0) co_await co::sleep_for(1ms);
+    }
+    done.count_down();
+}
+
+int main() {
+    co::executor ex{4};
+    std::stop_source stop;
+    std::latch exporter_done{1};
+    auto export_and_signal = [](co::executor& ex, std::stop_token token, std::latch& done) -> co::task<> {
+        co_await co::export_stats(ex, "co_stats.txt", 20ms, token);
+        done.count_down();
+    };
+    ex.spawn(export_and_signal(ex, stop.get_token(), exporter_done));
+
+    co::async_mutex m;
+    co::rate_limiter limiter{ex, 1000, 50'000.0};
+    std::latch done{8};
+    for (int i = 0; i < 8; ++i) ex.spawn(busy(m, limiter, done));
+    done.wait();
+
+    stop.request_stop();
+    exporter_done.wait();
+    std::cout << std::ifstream{"co_stats.txt"}.rdbuf();
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <atomic>
+#include <deque>
+#include <iostream>
+
+#include "co/sync.hpp"
+
+// phased batch job: every worker finishes phase p before anyone starts phase p + 1
+co::task<> phased(co::async_barrier& barrier, std::atomic<int>& work, co::async_latch& done) {
+    for (int phase = 0; phase < 3; ++phase) {
+        work.fetch_add(1, std::memory_order_relaxed);
+        co_await barrier.arrive_and_wait();
+    }
+    done.count_down();
+}
+
+// producer / consumer over an async condition variable
+struct channel {
+    co::async_mutex m;
+    co::async_condition_variable cv;
+    std::deque<int> items;
+    bool closed = false;
+};
+
+co::task<> consumer(channel& ch, std::atomic<int>& sum, co::async_latch& done) {
+    while (true) {
+        auto guard = co_await ch.m.scoped_lock();
+        co_await ch.cv.wait(ch.m, [&] { return !ch.items.empty() || ch.closed; });
+        if (ch.items.empty()) break;
+        sum += ch.items.front();
+        ch.items.pop_front();
+    }
+    done.count_down();
+}
+
+co::task<> producer(channel& ch) {
+    for (int i = 1; i <= 100; ++i) {
+        auto guard = co_await ch.m.scoped_lock();
+        ch.items.push_back(i);
+        ch.cv.notify_one();
+    }
+    auto guard = co_await ch.m.scoped_lock();
+    ch.closed = true;
+    ch.cv.notify_all();
+}
+
+co::task<> run(co::executor& ex) {
+    constexpr int n = 1000;
+    co::async_barrier barrier{n};
+    co::async_latch phases_done{n};
+    std::atomic<int> work{0};
+    for (int i = 0; i < n; ++i) ex.spawn(phased(barrier, work, phases_done));
+    co_await phases_done.wait();
+    std::cout << "phases: " << barrier.phase() << ", work items: " << work << std::endl;
+
+    channel ch;
+    co::async_latch consumers_done{4};
+    std::atomic<int> sum{0};
+    for (int i = 0; i < 4; ++i) ex.spawn(consumer(ch, sum, consumers_done));
+    co_await producer(ch);
+    co_await consumers_done.wait();
+    std::cout << "sum: " << sum << std::endl;
+}
+
+int main() {
+    co::executor ex{4};
+    ex.block_on(run(ex));
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "co/combinators.hpp"
+
+using namespace std::chrono_literals;
+
+co::task<int> slow_lookup() {
+    co_await co::sleep_for(500ms);
+    co_return 42;
+}
+
+co::task<int> flaky(int& calls) {
+    co_await co::sleep_for(1ms);
+    if (++calls < 3) throw std::runtime_error("unavailable");
+    co_return calls;
+}
+
+co::task<> run() {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        co_await co::with_timeout(slow_lookup(), 50ms);
+    } catch (const co::timed_out& e) {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        // the inner sleep was cancelled, not waited out
+        std::cout << e.what() << " after " << ms.count() << "ms" << std::endl;
+    }
+
+    std::cout << "in time: " << co_await co::with_timeout(slow_lookup(), 1s) << std::endl;
+
+    int calls = 0;
+    co::retry_policy policy{.max_attempts = 5, .initial_backoff = 20ms};
+    auto v = co_await co::retry(policy, [&] { return flaky(calls); });
+    std::cout << "retry succeeded on attempt " << v << std::endl;
+
+    // a timed out attempt is retried like any other failure
+    try {
+        co_await co::retry({.max_attempts = 2}, [] { return co::with_timeout(slow_lookup(), 10ms); });
+    } catch (const co::timed_out& e) {
+        std::cout << "gave up: " << e.what() << std::endl;
+    }
+}
+
+int main() {
+    co::executor ex{2};
+    ex.block_on(run());
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "co/generator.hpp"
+
+struct node {
+    int value = 0;
+    std::vector<std::unique_ptr<node>> children;
+};
+
+// pre-order, each subtree its own generator: elements_of resumes the deepest one directly
+co::generator<int> walk(const node& n) {
+    co_yield n.value;
+    for (auto& c: n.children) co_yield co::elements_of(walk(*c));
+}
+
+// the same, forwarding every element up through each level: a resume per level per element
+co::generator<int> walk_forwarding(const node& n) {
+    co_yield n.value;
+    for (auto& c: n.children) {
+        for (int v: walk_forwarding(*c)) co_yield v;
+    }
+}
+
+co::generator<int> failing(int depth) {
+    co_yield depth;
+    if (depth == 0) throw std::runtime_error("bad page");
+    co_yield co::elements_of(failing(depth - 1));
+}
+
+// a chain `depth` long whose every level also has `fanout` leaves
+std::unique_ptr<node> make_tree(int depth, int fanout, int& next) {
+    auto n = std::make_unique<node>();
+    n->value = next++;
+    for (int i = 0; i < fanout; ++i) {
+        auto leaf = std::make_unique<node>();
+        leaf->value = next++;
+        n->children.push_back(std::move(leaf));
+    }
+    if (depth > 1) n->children.push_back(make_tree(depth - 1, fanout, next));
+    return n;
+}
+
+template<class G>
+void timed(const char* name, const node& root, int nodes, G walker) {
+    auto start = std::chrono::steady_clock::now();
+    long sum = 0;
+    for (int v: walker(root)) sum += v;
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-12s sum %ld, %.1f ns/node\n", name, sum, ns / nodes);
+}
+
+int main() {
+    int small_count = 0;
+    auto small = make_tree(3, 2, small_count);
+    for (int v: walk(*small)) std::printf("%d ", v);
+    std::printf("\n");
+
+    try {
+        for (int v: failing(3)) std::printf("%d ", v);
+    } catch (const std::exception& e) {
+        std::printf("-> %s\n", e.what());
+    }
+
+    for (int depth: {10, 100, 1000}) {
+        int nodes = 0;
+        auto root = make_tree(depth, 16, nodes);
+        std::printf("depth %d, %d nodes\n", depth, nodes);
+        timed("elements_of", *root, nodes, walk);
+        timed("forwarding", *root, nodes, walk_forwarding);
+    }
+    return 0;
+}
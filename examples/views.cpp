@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdio>
+
+#include "co/generator.hpp"
+#include "co/views.hpp"
+
+using namespace co;
+
+constexpr int n = 1'000'000;
+
+generator<int> numbers(int n, int* produced = nullptr) {
+    for (int i = 0; i < n; ++i) {
+        if (produced) ++*produced;
+        co_yield i;
+    }
+}
+
+// the same pipeline with a generator per stage: every element is resumed through each
+generator<long> squares(generator<int> in) {
+    for (int v: in) co_yield long(v) * v;
+}
+
+generator<long> odd(generator<long> in) {
+    for (long v: in) {
+        if (v % 2) co_yield v;
+    }
+}
+
+template<class F>
+void timed(const char* name, F f) {
+    auto frames = runtime_stats::collect().frames_created;
+    auto start = std::chrono::steady_clock::now();
+    long sum = f();
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-18s sum %ld, %llu frames, %.2f ns/element\n", name, sum,
+                static_cast<unsigned long long>(runtime_stats::collect().frames_created - frames), ns / n);
+}
+
+int main() {
+    for (auto [i, chunk]: numbers(10) | views::map([](int v) { return v * v; }) | views::chunk(4) | views::enumerate) {
+        std::printf("chunk %zu:", i);
+        for (int v: chunk) std::printf(" %d", v);
+        std::printf("\n");
+    }
+
+    int produced = 0;
+    auto g = numbers(1'000'000, &produced);
+    for (int v: g | views::filter([](int v) { return v % 7 == 3; }) | views::take(3)) std::printf("%d ", v);
+    std::printf("(%d produced)\n", produced);
+
+    timed("views", [] {
+        long sum = 0;
+        for (long v: numbers(n) | views::map([](int v) { return long(v) * v; }) |
+                     views::filter([](long v) { return v % 2; })) {
+            sum += v;
+        }
+        return sum;
+    });
+    timed("nested generators", [] {
+        long sum = 0;
+        for (long v: odd(squares(numbers(n)))) sum += v;
+        return sum;
+    });
+    return 0;
+}
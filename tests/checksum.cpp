@@ -0,0 +1,77 @@
+// published check values for both hashes, and the SSE4.2 crc kernel against the table one
+// on every tail length and around the edges of its three interleaved runs
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "co/checksum.hpp"
+
+int failures = 0;
+
+void expect(bool ok, const char* what, std::size_t len) {
+    if (ok) return;
+    std::fprintf(stderr, "FAIL: %s, length %zu\n", what, len);
+    ++failures;
+}
+
+std::span<const std::byte> bytes(std::string_view s) { return std::as_bytes(std::span{s.data(), s.size()}); }
+
+int main() {
+    co::crc32c crc;
+    crc.update(bytes("123456789"));
+    expect(crc.value() == 0xe3069283u, "crc32c(\"123456789\")", 9);
+
+    co::xxhash64 empty;
+    expect(empty.value() == 0xef46db3751d8e999ull, "xxh64(\"\", 0)", 0);
+
+    std::vector<unsigned char> data(4 * co::detail::crc32c_stride + 64 + 8);
+    std::mt19937_64 rng{1};
+    for (auto& b: data) b = static_cast<unsigned char>(rng());
+
+    // one xxh64 fed in uneven pieces is one xxh64 over everything
+    for (std::size_t len: {0, 1, 31, 32, 33, 100, 4096}) {
+        auto all = std::as_bytes(std::span{data.data(), len});
+        co::xxhash64 whole{7}, pieces{7};
+        whole.update(all);
+        for (std::size_t at = 0, step = 1; at < len; at += step, step = step * 2 + 1) {
+            pieces.update(all.subspan(at, std::min(step, len - at)));
+        }
+        expect(whole.value() == pieces.value(), "xxh64 in pieces", len);
+    }
+
+    std::vector<std::size_t> lengths;
+    for (std::size_t n = 0; n <= 64; ++n) lengths.push_back(n);
+    for (std::size_t runs: {1, 2, 3, 4}) {
+        std::size_t edge = runs * co::detail::crc32c_stride;
+        for (std::size_t d = 0; d <= 16; ++d) {
+            lengths.push_back(edge - d);
+            lengths.push_back(edge + d);
+        }
+    }
+    for (int i = 0; i < 200; ++i) lengths.push_back(rng() % (data.size() - 8));
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    bool sse42 = __builtin_cpu_supports("sse4.2");
+#else
+    bool sse42 = false;
+#endif
+    std::size_t checked = 0;
+    for (auto len: lengths) {
+        // an odd start too, so the 8 byte loads are unaligned
+        for (std::size_t offset: {0, 3}) {
+            auto* p = data.data() + offset;
+            auto table = co::detail::crc32c_table(0xffffffffu, p, len);
+            expect(co::detail::crc32c_kernel(0xffffffffu, p, len) == table, "crc32c kernel vs table", len);
+#if defined(__x86_64__)
+            if (sse42) expect(co::detail::crc32c_sse42(0xffffffffu, p, len) == table, "crc32c sse4.2 vs table", len);
+#endif
+            ++checked;
+        }
+    }
+    std::printf("%zu crc32c inputs checked%s\n", checked, sse42 ? " on sse4.2" : ", no sse4.2 here");
+    return failures ? 1 : 0;
+}
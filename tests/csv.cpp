@@ -0,0 +1,79 @@
+// records and fields of `csv_records` on the inputs its 64 byte blocks make awkward: a
+// quoted field running on into the next block, escaped quotes, CRLF, empty fields, no
+// newline at the end, and an empty file
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "co/csv.hpp"
+#include "co/mapped_file.hpp"
+
+using records = std::vector<std::vector<std::string>>;
+
+int failures = 0;
+
+records parse(std::string_view text) {
+    records out;
+    for (auto fields: co::csv_records(text)) out.emplace_back(fields.begin(), fields.end());
+    return out;
+}
+
+void expect(const char* what, std::string_view text, const records& want) {
+    auto got = parse(text);
+    if (got == want) return;
+    std::fprintf(stderr, "FAIL: %s:", what);
+    for (auto& r: got) {
+        std::fprintf(stderr, " [");
+        for (auto& f: r) std::fprintf(stderr, "<%s>", f.c_str());
+        std::fprintf(stderr, "]");
+    }
+    std::fprintf(stderr, "\n");
+    ++failures;
+}
+
+int main() {
+    // the quote opens in the first block and closes in the second, with a delimiter and a
+    // newline on each side of the boundary that must not end the field
+    std::string pad(58, 'x');
+    std::string quoted = "a,b\nc" + std::string(20, 'y') + ",d\ne";
+    expect("quoted field across a block", pad + ",\"" + quoted + "\",z\nnext,row\n",
+           {{pad, quoted, "z"}, {"next", "row"}});
+
+    // and one that spans a whole block in between
+    std::string long_quoted = std::string(100, 'q') + "," + std::string(100, 'r');
+    expect("quoted field over a whole block", "1,\"" + long_quoted + "\"\n2,3\n", {{"1", long_quoted}, {"2", "3"}});
+
+    expect("escaped quotes", "\"say \"\"hi\"\"\",2\n\"\"\"\",3\n", {{"say \"\"hi\"\"", "2"}, {"\"\"", "3"}});
+    expect("crlf", "a,b\r\nc,d\r\n", {{"a", "b"}, {"c", "d"}});
+    expect("empty last field", "a,b,\nc,,\n", {{"a", "b", ""}, {"c", "", ""}});
+    expect("no newline at the end", "a,b\nc,d", {{"a", "b"}, {"c", "d"}});
+    expect("empty last field, no newline", "a,b,", {{"a", "b", ""}});
+    expect("crlf, no newline at the end", "a,b\r\nc,d\r", {{"a", "b"}, {"c", "d"}});
+    expect("blank lines", "\na\n\n\nb\n", {{"a"}, {"b"}});
+    expect("empty text", "", {});
+
+    char path[] = "/tmp/co_csv_XXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 1;
+    }
+    ::close(fd);
+    {
+        co::mapped_file empty{path};
+        int n = 0;
+        for (auto fields: co::csv_records(empty.text())) n += static_cast<int>(fields.size());
+        if (n) {
+            std::fprintf(stderr, "FAIL: an empty file gave %d fields\n", n);
+            ++failures;
+        }
+    }
+    ::unlink(path);
+
+    std::printf("%s\n", failures ? "csv: failures" : "csv: ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+// the reader fast path comes back after a short write section: the writer unlocks before
+// its inhibit window ends, so it's the next reader on the slow path that restores the bias
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "co/shared_mutex.hpp"
+#include "co/stats.hpp"
+
+using namespace std::chrono_literals;
+
+co::task<> short_write_then_reads(co::async_shared_mutex& m, int reads) {
+    co_await m.lock();
+    m.unlock();
+    std::this_thread::sleep_for(50ms);
+    for (int i = 0; i < reads; ++i) auto guard = co_await m.lock_shared();
+}
+
+int main() {
+    co::executor ex{1};
+    co::async_shared_mutex m;
+    constexpr int reads = 1000;
+    auto p = std::size_t(co::fast_path::shared_mutex_read);
+
+    auto before = co::runtime_stats::collect();
+    ex.block_on(short_write_then_reads(m, reads));
+    auto after = co::runtime_stats::collect();
+
+    auto hits = after.fast_hits[p] - before.fast_hits[p];
+    auto misses = after.fast_misses[p] - before.fast_misses[p];
+    std::printf("%llu fast, %llu slow of %d reads\n", static_cast<unsigned long long>(hits),
+                static_cast<unsigned long long>(misses), reads);
+    // the first read finds the bias off and turns it back on
+    if (misses > 1 || hits + misses != reads) {
+        std::fprintf(stderr, "FAIL: the reader fast path did not come back\n");
+        return 1;
+    }
+    return 0;
+}
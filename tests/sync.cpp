@@ -0,0 +1,71 @@
+// waking a task never runs it inside the call that woke it: `unlock`, `count_down` and
+// `notify_all` are made while holding a `std::mutex` that the woken task takes as soon as
+// it runs, which would deadlock if it ran on the waker's stack
+#include <cstdio>
+#include <mutex>
+
+#include "co/sync.hpp"
+
+struct shared_state {
+    std::mutex m;
+    int woken = 0;
+};
+
+co::task<> after_mutex(co::async_mutex& am, shared_state& s) {
+    auto guard = co_await am.scoped_lock();
+    std::lock_guard lk{s.m};
+    ++s.woken;
+}
+
+co::task<> after_latch(co::async_latch& l, shared_state& s) {
+    co_await l.wait();
+    std::lock_guard lk{s.m};
+    ++s.woken;
+}
+
+co::task<> after_notify(co::async_mutex& am, co::async_condition_variable& cv, bool& ready, shared_state& s) {
+    auto guard = co_await am.scoped_lock();
+    while (!ready) co_await cv.wait(am);
+    std::lock_guard lk{s.m};
+    ++s.woken;
+}
+
+co::task<int> wake_under_lock() {
+    auto& ex = *co::executor::current();
+    shared_state s;
+
+    co::async_mutex am;
+    co_await am.lock();
+    ex.spawn(after_mutex(am, s));
+    co::async_latch l{1};
+    ex.spawn(after_latch(l, s));
+    co::async_mutex cm;
+    co::async_condition_variable cv;
+    bool ready = false;
+    ex.spawn(after_notify(cm, cv, ready, s));
+    // let all three park themselves
+    co_await co::sleep_for(std::chrono::milliseconds{20});
+
+    {
+        std::lock_guard lk{s.m};
+        am.unlock();
+        l.count_down();
+        ready = true;  // read by the waiter under `cm`, which nobody holds now
+        cv.notify_all();
+        if (s.woken != 0) co_return -1;
+    }
+    co_await co::sleep_for(std::chrono::milliseconds{20});
+    std::lock_guard lk{s.m};
+    co_return s.woken;
+}
+
+int main() {
+    co::executor ex{1};
+    int woken = ex.block_on(wake_under_lock());
+    std::printf("%d of 3 woken\n", woken);
+    if (woken != 3) {
+        std::fprintf(stderr, "FAIL: %s\n", woken < 0 ? "a woken task ran inside the waker" : "a task was not woken");
+        return 1;
+    }
+    return 0;
+}